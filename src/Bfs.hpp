@@ -0,0 +1,55 @@
+#pragma once
+#include "Csr.hpp"
+
+// Reusable single-source BFS state. Besides hop distances it records the
+// number of shortest paths (sigma) and the visit order, which is what the
+// Brandes dependency accumulation walks backwards.
+struct BfsWorkspace {
+    std::vector<int32_t> distance;
+    std::vector<double> sigma;
+    std::vector<uint32_t> order;
+
+    void run(const CsrGraph& graph, uint32_t source) {
+        const size_t n = graph.nodeCount();
+        if (distance.size() != n) {
+            distance.assign(n, -1);
+            sigma.assign(n, 0.0);
+            order.reserve(n);
+        } else {
+            for (uint32_t v : order) {
+                distance[v] = -1;
+                sigma[v] = 0.0;
+            }
+        }
+        order.clear();
+
+        distance[source] = 0;
+        sigma[source] = 1.0;
+        order.push_back(source);
+
+        for (size_t head = 0; head < order.size(); ++head) {
+            uint32_t u = order[head];
+            for (const uint32_t* v = graph.begin(u); v != graph.end(u); ++v) {
+                if (distance[*v] < 0) {
+                    distance[*v] = distance[u] + 1;
+                    order.push_back(*v);
+                }
+                if (distance[*v] == distance[u] + 1) {
+                    sigma[*v] += sigma[u];
+                }
+            }
+        }
+    }
+
+    // Closeness of the last source, Wasserman-Faust scaled so that nodes in
+    // small components are not ranked above well connected ones.
+    double closeness() const {
+        if (order.size() <= 1 || distance.size() <= 1) return 0.0;
+
+        double total = 0.0;
+        for (uint32_t v : order) total += distance[v];
+
+        double reached = static_cast<double>(order.size() - 1);
+        return (reached / total) * (reached / static_cast<double>(distance.size() - 1));
+    }
+};
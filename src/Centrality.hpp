@@ -0,0 +1,96 @@
+#pragma once
+#include "Bfs.hpp"
+#include "Parallel.hpp"
+#include <cmath>
+#include <numeric>
+#include <random>
+
+struct BetweennessOptions {
+    // 0 runs exact Brandes from every source; otherwise k pivots are sampled.
+    size_t sampleCount = 0;
+    unsigned seed = 42;
+    // Failure probability for the reported error bound.
+    double confidence = 0.05;
+    bool undirected = true;
+};
+
+struct BetweennessResult {
+    std::vector<double> scores;
+    size_t sources = 0;
+    // Max absolute error of the normalised scores (score / ((n-1)(n-2))),
+    // holding with probability 1 - confidence; 0 for the exact run.
+    double errorBound = 0.0;
+};
+
+inline BetweennessResult computeBetweenness(const CsrGraph& graph, const BetweennessOptions& options = {}) {
+    BetweennessResult result;
+    const size_t n = graph.nodeCount();
+    result.scores.assign(n, 0.0);
+    if (n < 3) return result;
+
+    std::vector<uint32_t> sources(n);
+    std::iota(sources.begin(), sources.end(), 0u);
+    bool sampled = options.sampleCount > 0 && options.sampleCount < n;
+    if (sampled) {
+        std::mt19937 rng(options.seed);
+        std::shuffle(sources.begin(), sources.end(), rng);
+        sources.resize(options.sampleCount);
+    }
+    result.sources = sources.size();
+
+    // One dependency accumulator per worker, merged once all sources are done.
+    std::vector<std::vector<double>> partial(workerCount());
+    parallelFor(sources.size(), [&](size_t begin, size_t end, unsigned worker) {
+        std::vector<double>& accumulator = partial[worker];
+        accumulator.assign(n, 0.0);
+        std::vector<double> delta(n, 0.0);
+        BfsWorkspace bfs;
+
+        for (size_t i = begin; i < end; ++i) {
+            uint32_t source = sources[i];
+            bfs.run(graph, source);
+
+            for (uint32_t v : bfs.order) delta[v] = 0.0;
+            for (auto it = bfs.order.rbegin(); it != bfs.order.rend(); ++it) {
+                uint32_t v = *it;
+                for (const uint32_t* w = graph.begin(v); w != graph.end(v); ++w) {
+                    if (bfs.distance[*w] == bfs.distance[v] + 1) {
+                        delta[v] += bfs.sigma[v] / bfs.sigma[*w] * (1.0 + delta[*w]);
+                    }
+                }
+                if (v != source) accumulator[v] += delta[v];
+            }
+        }
+    }, 1);
+
+    for (const auto& accumulator : partial) {
+        for (size_t v = 0; v < accumulator.size(); ++v) {
+            result.scores[v] += accumulator[v];
+        }
+    }
+
+    double scale = options.undirected ? 0.5 : 1.0;
+    if (sampled) {
+        scale *= static_cast<double>(n) / sources.size();
+        // Hoeffding plus a union bound over all n nodes.
+        result.errorBound = std::sqrt(std::log(2.0 * n / options.confidence) / (2.0 * sources.size()));
+    }
+    for (double& score : result.scores) score *= scale;
+
+    return result;
+}
+
+inline std::vector<double> computeCloseness(const CsrGraph& graph) {
+    const size_t n = graph.nodeCount();
+    std::vector<double> closeness(n, 0.0);
+
+    parallelFor(n, [&](size_t begin, size_t end, unsigned) {
+        BfsWorkspace bfs;
+        for (size_t source = begin; source < end; ++source) {
+            bfs.run(graph, static_cast<uint32_t>(source));
+            closeness[source] = bfs.closeness();
+        }
+    }, 1);
+
+    return closeness;
+}
@@ -0,0 +1,432 @@
+#pragma once
+#include "EventLog.hpp"
+#include "Export.hpp"
+#include "Generators.hpp"
+#include "Graph.hpp"
+#include "Interaction.hpp"
+#include "Timeline.hpp"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Batch mode: load a matrix file (or replay a recorded session, ingest an
+// edge stream, or take a timeline at one moment), lay it out, run analytics
+// and write any of a matrix snapshot, metrics JSON, PNG and SVG. No window
+// is created, and the font and renderer are only set up when a PNG is
+// requested. --record, and --replay, --stream or --timeline without
+// --headless, run the interactive window instead (see main).
+struct CliOptions {
+    std::string input;
+    std::string generate;
+    uint64_t seed = 1;
+    std::string outputPath;
+    std::string recordPath;
+    std::string replayPath;
+    std::string streamPath;
+    std::string timelinePath;
+    // Moment of the timeline a batch run looks at; NaN means its end.
+    double timelineAt = std::numeric_limits<double>::quiet_NaN();
+    bool headless = false;
+    bool realtime = false;
+    std::string latencyPath;
+    std::string layout = "multilevel";
+    bool removeOverlaps = false;
+    bool pageRank = false;
+    bool betweenness = false;
+    bool closeness = false;
+    bool communities = false;
+    bool clustering = false;
+    std::string metricsPath;
+    std::string snapshotPath;
+    std::string pngPath;
+    std::string svgPath;
+    std::string memoryPath;
+    std::string tracePath;
+    std::string fontPath = "../Fonts/Arial.ttf";
+    ImageExportOptions image;
+
+    bool isInteractive() const {
+        return !recordPath.empty() ||
+               ((!replayPath.empty() || !streamPath.empty() || !timelinePath.empty()) && !headless);
+    }
+
+    // False when a generated graph only goes to --output, so its edges can
+    // stream straight to disk without being held in memory.
+    bool needsGraph() const {
+        return outputPath.empty() || layout == "stress" || removeOverlaps || pageRank || betweenness || closeness || communities ||
+               clustering || !metricsPath.empty() || !snapshotPath.empty() || !pngPath.empty() ||
+               !svgPath.empty() || !memoryPath.empty();
+    }
+};
+
+inline void printCliUsage() {
+    std::cerr << "Usage: GraphVisualizer --input <matrix|edges> [--layout multilevel|stress|none] [--remove-overlaps]\n"
+                 "         [--pagerank] [--betweenness] [--closeness] [--communities] [--clustering]\n"
+                 "         [--metrics <json>] [--snapshot <matrix>] [--png <file>] [--svg <file>]\n"
+                 "         [--memory <json>] [--trace <json>] [--size WxH] [--font <ttf>]\n"
+                 "       GraphVisualizer --generate <kind:key=value,...> [--seed <n>] [--output <edges>] [batch options]\n"
+                 "         kinds: gnp:n,p  gnm:n,m  ba:n,d  rmat:scale,edges,a,b,c  grid:rows,cols  rgg:n,radius\n"
+                 "       GraphVisualizer [--input <matrix>] --record <log>\n"
+                 "       GraphVisualizer --replay <log> [--headless] [--realtime] [--latency <csv>] [batch options]\n"
+                 "       GraphVisualizer [--input <matrix|edges>] --stream <file|fifo|-> [--headless] [batch options]\n"
+                 "       GraphVisualizer --timeline <events> [--headless [--at <time>]] [batch options]"
+              << std::endl;
+}
+
+inline bool parseCliArguments(int argc, char** argv, CliOptions& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string flag = argv[i];
+        auto value = [&](std::string& out) {
+            if (i + 1 >= argc) {
+                std::cerr << "Missing value for " << flag << std::endl;
+                return false;
+            }
+            out = argv[++i];
+            return true;
+        };
+
+        bool ok = true;
+        if (flag == "--input") ok = value(options.input);
+        else if (flag == "--generate") ok = value(options.generate);
+        else if (flag == "--output") ok = value(options.outputPath);
+        else if (flag == "--seed") {
+            std::string seed;
+            ok = value(seed);
+            if (ok) options.seed = std::strtoull(seed.c_str(), nullptr, 10);
+        }
+        else if (flag == "--layout") ok = value(options.layout);
+        else if (flag == "--remove-overlaps") options.removeOverlaps = true;
+        else if (flag == "--record") ok = value(options.recordPath);
+        else if (flag == "--replay") ok = value(options.replayPath);
+        else if (flag == "--stream") ok = value(options.streamPath);
+        else if (flag == "--timeline") ok = value(options.timelinePath);
+        else if (flag == "--at") {
+            std::string at;
+            ok = value(at);
+            if (ok) options.timelineAt = std::strtod(at.c_str(), nullptr);
+        }
+        else if (flag == "--headless") options.headless = true;
+        else if (flag == "--realtime") options.realtime = true;
+        else if (flag == "--latency") ok = value(options.latencyPath);
+        else if (flag == "--pagerank") options.pageRank = true;
+        else if (flag == "--betweenness") options.betweenness = true;
+        else if (flag == "--closeness") options.closeness = true;
+        else if (flag == "--communities") options.communities = true;
+        else if (flag == "--clustering") options.clustering = true;
+        else if (flag == "--metrics") ok = value(options.metricsPath);
+        else if (flag == "--snapshot") ok = value(options.snapshotPath);
+        else if (flag == "--png") ok = value(options.pngPath);
+        else if (flag == "--svg") ok = value(options.svgPath);
+        else if (flag == "--memory") ok = value(options.memoryPath);
+        else if (flag == "--trace") ok = value(options.tracePath);
+        else if (flag == "--font") ok = value(options.fontPath);
+        else if (flag == "--size") {
+            std::string size;
+            ok = value(size) &&
+                 std::sscanf(size.c_str(), "%ux%u", &options.image.width, &options.image.height) == 2;
+            if (!ok) std::cerr << "Expected --size WIDTHxHEIGHT" << std::endl;
+        } else {
+            std::cerr << "Unknown option: " << flag << std::endl;
+            ok = false;
+        }
+        if (!ok) return false;
+    }
+
+    if (options.input.empty() && options.generate.empty() && options.replayPath.empty() &&
+        options.recordPath.empty() && options.streamPath.empty() && options.timelinePath.empty()) {
+        std::cerr << "--input, --generate, --stream or --timeline is required" << std::endl;
+        return false;
+    }
+    if (options.layout != "multilevel" && options.layout != "stress" && options.layout != "none") {
+        std::cerr << "Unknown layout: " << options.layout << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Collects what a batch run computed and writes it as one JSON document.
+class CliMetrics {
+public:
+    void addTiming(const std::string& stage, double milliseconds) {
+        m_timings.emplace_back(stage, milliseconds);
+    }
+
+    void addSummary(const std::string& name, const std::string& json) {
+        m_summaries.emplace_back(name, json);
+    }
+
+    void addColumn(const std::string& name, std::vector<double> values) {
+        m_columns.emplace_back(name, std::move(values));
+    }
+
+    bool write(const Graph& graph, const std::string& path) const {
+        std::ofstream file(path);
+        if (!file.is_open()) {
+            std::cerr << "Failed to write metrics: " << path << std::endl;
+            return false;
+        }
+
+        const NodeStore& nodes = graph.getNodes();
+        file << "{\n  \"nodes\": " << nodes.size() << ",\n  \"edges\": " << graph.getEdges().size()
+             << ",\n  \"oriented\": " << (graph.isOriented() ? "true" : "false") << ",\n";
+        for (const auto& summary : m_summaries) {
+            file << "  \"" << summary.first << "\": " << summary.second << ",\n";
+        }
+
+        file << "  \"timingsMs\": {";
+        for (size_t i = 0; i < m_timings.size(); ++i) {
+            file << (i ? ", " : "") << '"' << m_timings[i].first << "\": " << m_timings[i].second;
+        }
+        file << "},\n";
+
+        file << "  \"perNode\": [\n";
+        for (size_t i = 0; i < nodes.size(); ++i) {
+            sf::Vector2f pos = nodes.getPosition(i);
+            file << "    {\"id\": " << nodes.getId(i) << ", \"x\": " << pos.x
+                 << ", \"y\": " << pos.y;
+            for (const auto& column : m_columns) {
+                file << ", \"" << column.first << "\": " << column.second[i];
+            }
+            file << (i + 1 < nodes.size() ? "},\n" : "}\n");
+        }
+        file << "  ]\n}\n";
+        return static_cast<bool>(file);
+    }
+
+private:
+    std::vector<std::pair<std::string, double>> m_timings;
+    std::vector<std::pair<std::string, std::string>> m_summaries;
+    std::vector<std::pair<std::string, std::vector<double>>> m_columns;
+};
+
+// Most events applied to the graph in one go, per frame in the window.
+constexpr size_t kStreamBatchSize = 1 << 16;
+
+inline int runCli(const CliOptions& options) {
+    CliMetrics metrics;
+    auto timed = [&](const std::string& stage, auto&& fn) {
+        auto start = std::chrono::steady_clock::now();
+        fn();
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        metrics.addTiming(stage, elapsed.count());
+    };
+
+    Graph graph("");
+    // The stress layout starts from its own Pivot MDS, so only multilevel
+    // runs lay the graph out on load, and replays, which need the positions
+    // the recorded session had before the stress layout runs.
+    graph.setLayoutOnLoad(options.layout == "multilevel" || (options.layout == "stress" && !options.replayPath.empty()));
+    EventReplayer replayer;
+    if (!options.replayPath.empty() && !replayer.open(options.replayPath)) return -1;
+
+    // Replays lay the graph out in the recorded window, as the session did.
+    if (!options.replayPath.empty()) {
+        sf::Vector2u window = replayer.getHeader().window;
+        graph.setLayoutArea(sf::Vector2f(static_cast<float>(window.x), static_cast<float>(window.y)));
+    }
+    std::string input = options.input.empty() ? replayer.getHeader().input : options.input;
+    bool loaded = true;
+    if (!input.empty()) timed("load", [&]() { loaded = graph.loadFile(input); });
+    if (!loaded) return -1;
+
+    auto removeOverlaps = [&]() {
+        timed("overlaps", [&]() {
+            OverlapRemovalResult result = graph.removeOverlaps();
+            metrics.addSummary("overlaps", "{\"stacked\": " + std::to_string(result.stacked) +
+                                           ", \"before\": " + std::to_string(result.overlapsBefore) +
+                                           ", \"after\": " + std::to_string(result.overlapsAfter) +
+                                           ", \"rounds\": " + std::to_string(result.iterations) + "}");
+        });
+    };
+
+    if (!options.generate.empty()) {
+        GeneratorSpec spec;
+        spec.seed = options.seed;
+        if (!GeneratorSpec::parse(options.generate, spec)) return -1;
+        GraphGenerator generator(spec);
+
+        EdgeListWriter writer;
+        if (!options.outputPath.empty() && !writer.open(options.outputPath, spec.n, false)) return -1;
+        std::vector<std::pair<uint32_t, uint32_t>> edges;
+        size_t generated = 0;
+        timed("generate", [&]() {
+            generator.run([&](const EdgeChunk& chunk) {
+                generated += chunk.size();
+                if (!options.outputPath.empty()) writer.write(chunk);
+                if (options.needsGraph()) edges.insert(edges.end(), chunk.begin(), chunk.end());
+            });
+        });
+        if (!writer.close()) {
+            std::cerr << "Failed to write edge list: " << options.outputPath << std::endl;
+            return -1;
+        }
+        std::cout << "Generated " << spec.n << " nodes and " << generated << " edges" << std::endl;
+        metrics.addSummary("generator", "{\"spec\": \"" + options.generate + "\", \"seed\": " +
+                                            std::to_string(spec.seed) + ", \"edges\": " + std::to_string(generated) + "}");
+
+        if (!options.needsGraph()) return options.tracePath.empty() || writeTraceFile(options.tracePath) ? 0 : -1;
+
+        std::vector<uint32_t> ids(spec.n);
+        for (size_t i = 0; i < ids.size(); ++i) ids[i] = static_cast<uint32_t>(i + 1);
+        bool loaded = true;
+        timed("load", [&]() { loaded = graph.assignEdges(ids, edges, false, generator.positions()); });
+        if (!loaded) return -1;
+    }
+
+    if (!options.streamPath.empty()) {
+        EdgeStreamReader stream;
+        if (!stream.start(options.streamPath)) return -1;
+        std::vector<EdgeEvent> events;
+        size_t applied = 0;
+        double elapsed = 0.0;
+        timed("stream", [&]() {
+            auto start = std::chrono::steady_clock::now();
+            while (!stream.isFinished()) {
+                events.clear();
+                if (!stream.poll(events, kStreamBatchSize)) {
+                    std::this_thread::yield();
+                    continue;
+                }
+                applied += graph.applyEdgeEvents(events);
+            }
+            elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        });
+        uint64_t received = stream.getEventCount();
+        double rate = elapsed > 0.0 ? received / elapsed : 0.0;
+        std::cout << "Streamed " << received << " events (" << applied << " applied, " << stream.getMalformedCount()
+                  << " malformed) at " << static_cast<uint64_t>(rate) << " events/s" << std::endl;
+        metrics.addSummary("stream", "{\"events\": " + std::to_string(received) + ", \"applied\": " +
+                                         std::to_string(applied) + ", \"malformed\": " +
+                                         std::to_string(stream.getMalformedCount()) + ", \"eventsPerSecond\": " +
+                                         std::to_string(rate) + "}");
+    }
+
+    if (!options.timelinePath.empty()) {
+        std::vector<TimedEdgeEvent> events;
+        if (!loadTimedEdgeEvents(options.timelinePath, events)) return -1;
+        Timeline timeline;
+        timed("timeline", [&]() { timeline.build(std::move(events)); });
+        TemporalPlayback playback(graph, std::move(timeline));
+        double at = std::isnan(options.timelineAt) ? playback.getEndTime() : options.timelineAt;
+        timed("seek", [&]() { playback.seek(at, false); });
+
+        const Timeline& built = playback.getTimeline();
+        std::cout << "Timeline of " << built.eventCount() << " events over " << built.nodeCount() << " nodes, "
+                  << built.checkpointCount() << " checkpoints; showing t = " << playback.getTime() << std::endl;
+        metrics.addSummary("timeline", "{\"events\": " + std::to_string(built.eventCount()) +
+                                           ", \"checkpoints\": " + std::to_string(built.checkpointCount()) +
+                                           ", \"layouts\": " + std::to_string(built.layoutCount()) +
+                                           ", \"checkpointBytes\": " + std::to_string(built.memoryBytes()) +
+                                           ", \"start\": " + std::to_string(built.getStartTime()) +
+                                           ", \"end\": " + std::to_string(built.getEndTime()) +
+                                           ", \"at\": " + std::to_string(playback.getTime()) + "}");
+    }
+
+    // Before a replay, as in the recorded session; a stress layout is
+    // cleaned up once it has been computed below.
+    if (options.removeOverlaps && options.layout != "stress") removeOverlaps();
+
+    if (!options.replayPath.empty()) {
+        Interaction interaction(graph, nullptr, nullptr, replayer.getHeader().window);
+        interaction.setDeterministic(true);
+        interaction.setLogging(false);
+        LatencyReport report;
+        timed("replay", [&]() {
+            replayEvents(replayer, options.realtime, report, [&](const sf::Event& event) {
+                bool keepGoing = interaction.handleEvent(event);
+                graph.pollLayout();
+                return keepGoing;
+            });
+        });
+        report.printSummary(std::cout);
+        if (!options.latencyPath.empty() && !report.writeCsv(options.latencyPath)) return -1;
+    }
+
+    if (options.layout == "stress") {
+        timed("layout", [&]() {
+            graph.applyStressLayout();
+            graph.finishLayoutRefinement();
+        });
+        if (options.removeOverlaps) removeOverlaps();
+    }
+
+    if (options.pageRank) {
+        timed("pagerank", [&]() {
+            PageRankResult result = graph.applyPageRank();
+            metrics.addSummary("pagerank", "{\"iterations\": " + std::to_string(result.iterations) +
+                                           ", \"residual\": " + std::to_string(result.residual) +
+                                           ", \"converged\": " + (result.converged ? "true" : "false") + "}");
+            metrics.addColumn("pagerank", result.ranks);
+        });
+    }
+    if (options.betweenness) {
+        timed("betweenness", [&]() {
+            BetweennessResult result = graph.applyBetweenness();
+            metrics.addSummary("betweenness", "{\"sources\": " + std::to_string(result.sources) +
+                                              ", \"errorBound\": " + std::to_string(result.errorBound) + "}");
+            metrics.addColumn("betweenness", result.scores);
+        });
+    }
+    if (options.closeness) {
+        timed("closeness", [&]() { metrics.addColumn("closeness", graph.applyCloseness()); });
+    }
+    if (options.communities) {
+        timed("communities", [&]() {
+            LouvainResult result = graph.applyCommunities();
+            metrics.addSummary("communities", "{\"count\": " + std::to_string(result.communityCount) +
+                                              ", \"modularity\": " + std::to_string(result.modularity) + "}");
+            metrics.addColumn("community", std::vector<double>(result.community.begin(), result.community.end()));
+        });
+    }
+    if (options.clustering) {
+        timed("clustering", [&]() {
+            TriangleResult result = graph.applyClustering();
+            metrics.addSummary("clustering", "{\"triangles\": " + std::to_string(result.total) +
+                                             ", \"global\": " + std::to_string(result.globalClustering) +
+                                             ", \"average\": " + std::to_string(result.averageClustering) +
+                                             ", \"method\": \"" + (result.usedBitset ? "bitset" : "merge") + "\"}");
+            metrics.addColumn("triangles", std::vector<double>(result.triangles.begin(), result.triangles.end()));
+            metrics.addColumn("clustering", result.clustering);
+        });
+    }
+
+    bool ok = true;
+    MemoryReport memory;
+    if (!options.snapshotPath.empty()) ok &= graph.saveFile(options.snapshotPath);
+    if (!options.svgPath.empty()) timed("svg", [&]() { ok &= exportSvg(graph, options.svgPath, options.image); });
+    if (!options.pngPath.empty()) {
+        sf::Font font;
+        if (!font.loadFromFile(options.fontPath)) {
+            std::cerr << "Error loading font" << std::endl;
+            return -1;
+        }
+        GraphView view(graph, font);
+        timed("png", [&]() { ok &= exportPng(view, options.pngPath, options.image); });
+        // Measured while the renderer still exists.
+        view.reportMemory(memory);
+    }
+    if (memory.empty()) graph.reportMemory(memory);
+
+    std::ostringstream memoryJson;
+    memory.writeJson(memoryJson);
+    metrics.addSummary("memory", memoryJson.str());
+    if (!options.memoryPath.empty()) {
+        std::ofstream file(options.memoryPath);
+        if (!(file << memoryJson.str() << '\n')) {
+            std::cerr << "Failed to write memory report: " << options.memoryPath << std::endl;
+            ok = false;
+        }
+    }
+    if (!options.metricsPath.empty()) ok &= metrics.write(graph, options.metricsPath);
+    if (!options.tracePath.empty()) ok &= writeTraceFile(options.tracePath);
+    return ok ? 0 : -1;
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include <atomic>
+#include <memory>
+
+// A value shared between copies until one of them writes to it. Copying
+// is O(1); write() clones the value first if anyone else still holds it.
+// Holders may live on other threads as long as each copy is used by one.
+template <typename T>
+class CopyOnWrite {
+public:
+    CopyOnWrite() : m_value(std::make_shared<T>()) {}
+    // Moves share too, so a moved-from copy still holds a value.
+    CopyOnWrite(const CopyOnWrite&) = default;
+    CopyOnWrite& operator=(const CopyOnWrite&) = default;
+
+    const T& read() const { return *m_value; }
+
+    T& write() {
+        if (m_value.use_count() != 1) {
+            m_value = std::make_shared<T>(*m_value);
+        } else {
+            // Pairs with the release of the last other holder, so its reads
+            // finish before ours writes.
+            std::atomic_thread_fence(std::memory_order_acquire);
+        }
+        return *m_value;
+    }
+
+    // Replaces the value with an empty one without copying the old one.
+    void reset() { m_value = std::make_shared<T>(); }
+
+private:
+    std::shared_ptr<T> m_value;
+};
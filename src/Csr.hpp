@@ -0,0 +1,136 @@
+#pragma once
+#include "Parallel.hpp"
+#include <cstddef>
+#include <algorithm>
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Compressed sparse row adjacency: the neighbours of u are
+// targets[offsets[u] .. offsets[u + 1]).
+struct CsrGraph {
+    std::vector<uint32_t> offsets;
+    std::vector<uint32_t> targets;
+
+    size_t nodeCount() const { return offsets.empty() ? 0 : offsets.size() - 1; }
+    size_t edgeCount() const { return targets.size(); }
+    uint32_t degree(uint32_t u) const { return offsets[u + 1] - offsets[u]; }
+
+    const uint32_t* begin(uint32_t u) const { return targets.data() + offsets[u]; }
+    const uint32_t* end(uint32_t u) const { return targets.data() + offsets[u + 1]; }
+
+    size_t memoryBytes() const {
+        return (offsets.capacity() + targets.capacity()) * sizeof(uint32_t);
+    }
+
+    static CsrGraph fromEdges(size_t count, const std::vector<std::pair<uint32_t, uint32_t>>& edges) {
+        CsrGraph csr;
+        csr.offsets.assign(count + 1, 0);
+        for (const auto& edge : edges) {
+            ++csr.offsets[edge.first + 1];
+        }
+        for (size_t i = 0; i < count; ++i) {
+            csr.offsets[i + 1] += csr.offsets[i];
+        }
+
+        csr.targets.resize(edges.size());
+        std::vector<uint32_t> cursor(csr.offsets.begin(), csr.offsets.end() - 1);
+        for (const auto& edge : edges) {
+            csr.targets[cursor[edge.first]++] = edge.second;
+        }
+        return csr;
+    }
+
+    // Sorts every row and drops repeated targets, in parallel over rows.
+    void sortRows() {
+        std::vector<uint32_t> kept(nodeCount(), 0);
+        parallelFor(nodeCount(), [&](size_t first, size_t last, unsigned) {
+            for (size_t u = first; u < last; ++u) {
+                uint32_t* row = targets.data() + offsets[u];
+                uint32_t* rowEnd = targets.data() + offsets[u + 1];
+                std::sort(row, rowEnd);
+                kept[u] = static_cast<uint32_t>(std::unique(row, rowEnd) - row);
+            }
+        }, 256);
+
+        size_t write = 0;
+        for (size_t u = 0; u < nodeCount(); ++u) {
+            uint32_t read = offsets[u];
+            offsets[u] = static_cast<uint32_t>(write);
+            for (uint32_t k = 0; k < kept[u]; ++k) targets[write++] = targets[read + k];
+        }
+        if (!offsets.empty()) offsets.back() = static_cast<uint32_t>(write);
+        targets.resize(write);
+    }
+
+    // The CSC view of this graph, i.e. the CSR of the reversed edges.
+    CsrGraph transposed() const {
+        std::vector<std::pair<uint32_t, uint32_t>> reversed;
+        reversed.reserve(targets.size());
+        for (uint32_t u = 0; u < nodeCount(); ++u) {
+            for (const uint32_t* v = begin(u); v != end(u); ++v) {
+                reversed.emplace_back(*v, u);
+            }
+        }
+        return fromEdges(nodeCount(), reversed);
+    }
+};
+
+// Symmetric weighted adjacency used by the multi-level algorithms. Row sums
+// are the weighted degrees; a self loop on a contracted node carries the
+// weight of the edges it absorbed.
+struct WeightedCsr {
+    std::vector<uint32_t> offsets;
+    std::vector<uint32_t> targets;
+    std::vector<double> weights;
+
+    size_t nodeCount() const { return offsets.empty() ? 0 : offsets.size() - 1; }
+
+    static WeightedCsr fromCsr(const CsrGraph& graph) {
+        WeightedCsr weighted;
+        weighted.offsets = graph.offsets;
+        weighted.targets = graph.targets;
+        weighted.weights.assign(graph.targets.size(), 1.0);
+        return weighted;
+    }
+
+    // Merges every group of nodes sharing a membership id into one node,
+    // summing the weights of the edges between groups.
+    WeightedCsr contracted(const std::vector<uint32_t>& membership, size_t count) const {
+        std::vector<std::vector<uint32_t>> members(count);
+        for (uint32_t u = 0; u < membership.size(); ++u) {
+            members[membership[u]].push_back(u);
+        }
+
+        std::vector<std::vector<std::pair<uint32_t, double>>> rows(count);
+        parallelFor(count, [&](size_t begin, size_t end, unsigned) {
+            std::unordered_map<uint32_t, double> links;
+            for (size_t c = begin; c < end; ++c) {
+                links.clear();
+                for (uint32_t u : members[c]) {
+                    for (uint32_t e = offsets[u]; e < offsets[u + 1]; ++e) {
+                        links[membership[targets[e]]] += weights[e];
+                    }
+                }
+                rows[c].assign(links.begin(), links.end());
+                std::sort(rows[c].begin(), rows[c].end());
+            }
+        }, 64);
+
+        WeightedCsr next;
+        next.offsets.assign(count + 1, 0);
+        for (size_t c = 0; c < count; ++c) {
+            next.offsets[c + 1] = next.offsets[c] + static_cast<uint32_t>(rows[c].size());
+        }
+        next.targets.reserve(next.offsets.back());
+        next.weights.reserve(next.offsets.back());
+        for (const auto& row : rows) {
+            for (const auto& [target, weight] : row) {
+                next.targets.push_back(target);
+                next.weights.push_back(weight);
+            }
+        }
+        return next;
+    }
+};
@@ -0,0 +1,230 @@
+#pragma once
+#include "Memory.hpp"
+#include "Parallel.hpp"
+#include "SpatialGrid.hpp"
+#include "Trace.hpp"
+#include <SFML/Graphics.hpp>
+
+struct EdgeBundlingOptions {
+    float compatibilityThreshold = 0.6f;
+    float stiffness = 0.1f;
+    float initialStep = 0.1f;
+    int cycles = 6;
+    int initialIterations = 90;
+    // Nodes may drift this far (in pixels) before the bundles are rebuilt.
+    float rebuildThreshold = 5.f;
+};
+
+// Force-directed edge bundling (Holten & van Wijk 2009). Edges are subdivided
+// into polylines whose points attract the matching points of compatible
+// edges; each cycle doubles the subdivision. The result is cached as a single
+// line-list vertex array and rebuilt only when edges change or some node has
+// moved further than rebuildThreshold since the last build.
+class EdgeBundler {
+public:
+    explicit EdgeBundler(const EdgeBundlingOptions& options = {}) : m_options(options) {}
+
+    void invalidate() { m_valid = false; }
+
+    // Returns true when the cached geometry had to be rebuilt.
+    bool update(const std::vector<sf::Vector2f>& nodes, const std::vector<std::pair<uint32_t, uint32_t>>& edges,
+                bool oriented) {
+        if (m_valid && m_edges == edges && m_oriented == oriented && !movedBeyondThreshold(nodes)) {
+            return false;
+        }
+
+        m_nodes = nodes;
+        m_edges = edges;
+        m_oriented = oriented;
+        rebuild();
+        m_valid = true;
+        return true;
+    }
+
+    const sf::VertexArray& getVertices() const { return m_vertices; }
+
+    MemoryUsage memoryUsage() const {
+        MemoryUsage usage;
+        usage.bytes = heapBytes(m_nodes) + heapBytes(m_edges) + vertexBytes(m_vertices);
+        usage.objects = m_vertices.getVertexCount();
+        return usage;
+    }
+
+private:
+    EdgeBundlingOptions m_options;
+    bool m_valid = false;
+    bool m_oriented = false;
+    std::vector<sf::Vector2f> m_nodes;
+    std::vector<std::pair<uint32_t, uint32_t>> m_edges;
+    sf::VertexArray m_vertices{sf::Lines};
+
+    bool movedBeyondThreshold(const std::vector<sf::Vector2f>& nodes) const {
+        if (nodes.size() != m_nodes.size()) return true;
+        const float limit = m_options.rebuildThreshold * m_options.rebuildThreshold;
+        for (size_t i = 0; i < nodes.size(); ++i) {
+            sf::Vector2f delta = nodes[i] - m_nodes[i];
+            if (delta.x * delta.x + delta.y * delta.y > limit) return true;
+        }
+        return false;
+    }
+
+    static float length(const sf::Vector2f& v) { return std::sqrt(v.x * v.x + v.y * v.y); }
+    static float dot(const sf::Vector2f& a, const sf::Vector2f& b) { return a.x * b.x + a.y * b.y; }
+
+    // How far the projection of q onto the line through p stays centred on p.
+    static float visibility(sf::Vector2f p0, sf::Vector2f p1, sf::Vector2f q0, sf::Vector2f q1) {
+        sf::Vector2f dir = p1 - p0;
+        float len2 = dot(dir, dir);
+        if (len2 <= 0.f) return 0.f;
+        sf::Vector2f i0 = p0 + dir * (dot(q0 - p0, dir) / len2);
+        sf::Vector2f i1 = p0 + dir * (dot(q1 - p0, dir) / len2);
+        float span = length(i1 - i0);
+        if (span <= 0.f) return 0.f;
+        sf::Vector2f mid = (p0 + p1) / 2.f;
+        sf::Vector2f projectedMid = (i0 + i1) / 2.f;
+        return std::max(0.f, 1.f - 2.f * length(mid - projectedMid) / span);
+    }
+
+    float compatibility(size_t a, size_t b) const {
+        sf::Vector2f p0 = m_nodes[m_edges[a].first], p1 = m_nodes[m_edges[a].second];
+        sf::Vector2f q0 = m_nodes[m_edges[b].first], q1 = m_nodes[m_edges[b].second];
+        sf::Vector2f p = p1 - p0, q = q1 - q0;
+        float lp = length(p), lq = length(q);
+        if (lp <= 0.f || lq <= 0.f) return 0.f;
+
+        float average = (lp + lq) / 2.f;
+        float angle = std::abs(dot(p, q) / (lp * lq));
+        float scale = 2.f / (average / std::min(lp, lq) + std::max(lp, lq) / average);
+        float position = average / (average + length((p0 + p1) / 2.f - (q0 + q1) / 2.f));
+        float visible = std::min(visibility(p0, p1, q0, q1), visibility(q0, q1, p0, p1));
+        return angle * scale * position * visible;
+    }
+
+    std::vector<std::vector<uint32_t>> compatibleEdges() const {
+        const size_t m = m_edges.size();
+        std::vector<sf::Vector2f> midpoints(m);
+        float longest = 0.f;
+        for (size_t e = 0; e < m; ++e) {
+            sf::Vector2f p0 = m_nodes[m_edges[e].first], p1 = m_nodes[m_edges[e].second];
+            midpoints[e] = (p0 + p1) / 2.f;
+            longest = std::max(longest, length(p1 - p0));
+        }
+
+        // Position compatibility alone already rules out midpoints further
+        // apart than average * (1 / threshold - 1), so only nearby edges are
+        // scored.
+        float reach = 1.f / m_options.compatibilityThreshold - 1.f;
+        SpatialGrid grid;
+        grid.build(midpoints, std::max(longest * reach, 1.f));
+
+        std::vector<std::vector<uint32_t>> compatible(m);
+        parallelFor(m, [&](size_t begin, size_t end, unsigned) {
+            for (size_t e = begin; e < end; ++e) {
+                float own = length(m_nodes[m_edges[e].second] - m_nodes[m_edges[e].first]);
+                float radius = reach * (own + longest) / 2.f;
+                grid.forEachNear(midpoints[e], radius, [&](uint32_t other) {
+                    if (other != e && compatibility(e, other) >= m_options.compatibilityThreshold) {
+                        compatible[e].push_back(other);
+                    }
+                });
+            }
+        }, 64);
+        return compatible;
+    }
+
+    void rebuild() {
+        TRACE_ZONE("EdgeBundler::rebuild");
+        const size_t m = m_edges.size();
+        std::vector<std::vector<uint32_t>> compatible = compatibleEdges();
+
+        // points[e] always holds both endpoints plus the inner subdivision.
+        std::vector<std::vector<sf::Vector2f>> points(m);
+        for (size_t e = 0; e < m; ++e) {
+            points[e] = {m_nodes[m_edges[e].first], m_nodes[m_edges[e].second]};
+        }
+
+        size_t subdivisions = 1;
+        float step = m_options.initialStep;
+        float iterations = static_cast<float>(m_options.initialIterations);
+        std::vector<std::vector<sf::Vector2f>> next(m);
+
+        for (int cycle = 0; cycle < m_options.cycles; ++cycle) {
+            for (auto& polyline : points) polyline = resample(polyline, subdivisions);
+
+            for (int iteration = 0; iteration < static_cast<int>(iterations); ++iteration) {
+                parallelFor(m, [&](size_t begin, size_t end, unsigned) {
+                    for (size_t e = begin; e < end; ++e) {
+                        const auto& own = points[e];
+                        next[e] = own;
+                        float span = length(own.back() - own.front());
+                        if (span <= 0.f) continue;
+
+                        float spring = m_options.stiffness / (span * (subdivisions + 1));
+                        for (size_t i = 1; i + 1 < own.size(); ++i) {
+                            sf::Vector2f force = (own[i - 1] - own[i] + own[i + 1] - own[i]) * spring;
+                            for (uint32_t other : compatible[e]) {
+                                const auto& theirs = points[other];
+                                // Reversed edges pair their subdivision points back to front.
+                                bool reversed = dot(own.back() - own.front(), theirs.back() - theirs.front()) < 0.f;
+                                sf::Vector2f delta = theirs[reversed ? theirs.size() - 1 - i : i] - own[i];
+                                float distance = length(delta);
+                                if (distance > 1e-4f) force += delta / distance;
+                            }
+                            next[e][i] = own[i] + force * step;
+                        }
+                    }
+                }, 64);
+                points.swap(next);
+            }
+
+            subdivisions *= 2;
+            step /= 2.f;
+            iterations *= 2.f / 3.f;
+        }
+
+        m_vertices.clear();
+        const sf::Color startColor(235, 64, 52, 110);
+        const sf::Color endColor(52, 64, 235, 110);
+        for (const auto& polyline : points) {
+            for (size_t i = 0; i + 1 < polyline.size(); ++i) {
+                float t0 = float(i) / (polyline.size() - 1);
+                float t1 = float(i + 1) / (polyline.size() - 1);
+                m_vertices.append(sf::Vertex(polyline[i], m_oriented ? blend(startColor, endColor, t0) : startColor));
+                m_vertices.append(sf::Vertex(polyline[i + 1], m_oriented ? blend(startColor, endColor, t1) : startColor));
+            }
+        }
+    }
+
+    static sf::Color blend(const sf::Color& a, const sf::Color& b, float t) {
+        return sf::Color(static_cast<sf::Uint8>(a.r + (b.r - a.r) * t),
+                         static_cast<sf::Uint8>(a.g + (b.g - a.g) * t),
+                         static_cast<sf::Uint8>(a.b + (b.b - a.b) * t), a.a);
+    }
+
+    // Redistributes a polyline to `subdivisions` evenly spaced inner points.
+    static std::vector<sf::Vector2f> resample(const std::vector<sf::Vector2f>& polyline, size_t subdivisions) {
+        float total = 0.f;
+        for (size_t i = 0; i + 1 < polyline.size(); ++i) total += length(polyline[i + 1] - polyline[i]);
+
+        std::vector<sf::Vector2f> result;
+        result.reserve(subdivisions + 2);
+        result.push_back(polyline.front());
+        if (total > 0.f) {
+            float spacing = total / (subdivisions + 1);
+            float target = spacing;
+            float walked = 0.f;
+            for (size_t i = 0; i + 1 < polyline.size() && result.size() <= subdivisions; ++i) {
+                float segment = length(polyline[i + 1] - polyline[i]);
+                while (segment > 0.f && walked + segment >= target && result.size() <= subdivisions) {
+                    float t = (target - walked) / segment;
+                    result.push_back(polyline[i] + (polyline[i + 1] - polyline[i]) * t);
+                    target += spacing;
+                }
+                walked += segment;
+            }
+        }
+        while (result.size() <= subdivisions) result.push_back(polyline.back());
+        result.push_back(polyline.back());
+        return result;
+    }
+};
@@ -0,0 +1,177 @@
+#pragma once
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Plain-text edge lists for graphs too big for the adjacency matrix format:
+//
+//   # GraphVisualizer edge list
+//   <node count> <1 if oriented, else 0>
+//   <u> <v>
+//   ...
+//
+// Node indices are 0-based; lines starting with '#' are comments. Both
+// directions go through fixed buffers and <charconv>, so 10^8 edges stream
+// in and out without iostream formatting.
+class EdgeListWriter {
+public:
+    static constexpr size_t kFlushSize = 1 << 20;
+
+    ~EdgeListWriter() { close(); }
+
+    bool open(const std::string& path, size_t nodeCount, bool oriented) {
+        m_file.open(path, std::ios::binary);
+        if (!m_file.is_open()) {
+            std::cerr << "Failed to write edge list: " << path << std::endl;
+            return false;
+        }
+        m_buffer.reserve(kFlushSize + 64);
+        m_buffer = "# GraphVisualizer edge list\n";
+        appendNumber(nodeCount, ' ');
+        appendNumber(oriented ? 1 : 0, '\n');
+        return true;
+    }
+
+    void write(const std::vector<std::pair<uint32_t, uint32_t>>& edges) {
+        for (const auto& edge : edges) {
+            appendNumber(edge.first, ' ');
+            appendNumber(edge.second, '\n');
+            if (m_buffer.size() >= kFlushSize) flush();
+        }
+        m_edgeCount += edges.size();
+    }
+
+    size_t getEdgeCount() const { return m_edgeCount; }
+
+    bool close() {
+        if (!m_file.is_open()) return true;
+        flush();
+        m_file.close();
+        return !m_file.fail();
+    }
+
+private:
+    std::ofstream m_file;
+    std::string m_buffer;
+    size_t m_edgeCount = 0;
+
+    void appendNumber(uint64_t value, char separator) {
+        char text[24];
+        char* end = std::to_chars(text, text + sizeof(text), value).ptr;
+        *end++ = separator;
+        m_buffer.append(text, end);
+    }
+
+    void flush() {
+        m_file.write(m_buffer.data(), static_cast<std::streamsize>(m_buffer.size()));
+        m_buffer.clear();
+    }
+};
+
+class EdgeListReader {
+public:
+    static constexpr size_t kBufferSize = 1 << 20;
+
+    bool open(const std::string& path) {
+        m_file.open(path, std::ios::binary);
+        uint64_t nodes = 0;
+        uint64_t oriented = 0;
+        if (!m_file.is_open() || !nextNumber(nodes) || !nextNumber(oriented)) {
+            std::cerr << "Failed to read edge list: " << path << std::endl;
+            return false;
+        }
+        m_nodeCount = static_cast<size_t>(nodes);
+        m_oriented = oriented != 0;
+        return true;
+    }
+
+    size_t getNodeCount() const { return m_nodeCount; }
+    bool isOriented() const { return m_oriented; }
+
+    // Whether reading stopped at something other than a clean end of file:
+    // a token that is not a node index, or an edge missing its second end.
+    bool hasError() const { return m_error; }
+
+    // Appends up to maxEdges edges; returns false once the file is done or
+    // malformed (see hasError). Edges naming nodes outside the header's
+    // count are skipped.
+    bool read(std::vector<std::pair<uint32_t, uint32_t>>& edges, size_t maxEdges = SIZE_MAX) {
+        uint64_t u = 0, v = 0;
+        for (size_t i = 0; i < maxEdges; ++i) {
+            if (!nextNumber(u)) return false;
+            if (!nextNumber(v)) {
+                m_error = true;
+                return false;
+            }
+            if (u < m_nodeCount && v < m_nodeCount) edges.emplace_back(static_cast<uint32_t>(u), static_cast<uint32_t>(v));
+        }
+        return true;
+    }
+
+private:
+    std::ifstream m_file;
+    std::vector<char> m_buffer = std::vector<char>(kBufferSize);
+    size_t m_position = 0;
+    size_t m_end = 0;
+    size_t m_nodeCount = 0;
+    bool m_oriented = false;
+    bool m_error = false;
+
+    // Keeps the unread tail and tops the buffer up; false at end of file.
+    bool refill() {
+        size_t kept = m_end - m_position;
+        std::memmove(m_buffer.data(), m_buffer.data() + m_position, kept);
+        m_position = 0;
+        m_end = kept;
+        m_file.read(m_buffer.data() + kept, static_cast<std::streamsize>(m_buffer.size() - kept));
+        m_end += static_cast<size_t>(m_file.gcount());
+        return m_end > kept;
+    }
+
+    bool nextNumber(uint64_t& value) {
+        while (true) {
+            if (m_position == m_end && !refill()) return false;
+            char c = m_buffer[m_position];
+            if (c == '#') {
+                // Skip to the end of the comment line.
+                while (true) {
+                    const char* newline = static_cast<const char*>(
+                        std::memchr(m_buffer.data() + m_position, '\n', m_end - m_position));
+                    if (newline) {
+                        m_position = newline - m_buffer.data() + 1;
+                        break;
+                    }
+                    m_position = m_end;
+                    if (!refill()) return false;
+                }
+            } else if (c == ' ' || c == '\n' || c == '\r' || c == '\t') {
+                ++m_position;
+            } else {
+                break;
+            }
+        }
+
+        // A number cut off by the end of the buffer is completed first.
+        size_t digits = m_position;
+        while (digits < m_end && m_buffer[digits] >= '0' && m_buffer[digits] <= '9') ++digits;
+        if (digits == m_end && !m_file.eof()) {
+            size_t offset = digits - m_position;
+            refill();
+            digits = m_position + offset;
+            while (digits < m_end && m_buffer[digits] >= '0' && m_buffer[digits] <= '9') ++digits;
+        }
+
+        auto parsed = std::from_chars(m_buffer.data() + m_position, m_buffer.data() + digits, value);
+        if (parsed.ec != std::errc()) {
+            m_error = true;
+            return false;
+        }
+        m_position = parsed.ptr - m_buffer.data();
+        return true;
+    }
+};
@@ -0,0 +1,223 @@
+#pragma once
+#include "Trace.hpp"
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#if defined(_WIN32)
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+// Bounded single-producer single-consumer ring. Each side owns one index
+// and only reads the other's, caching it so the shared cache line is
+// touched once per batch rather than once per item.
+template <typename T>
+class SpscQueue {
+public:
+    explicit SpscQueue(size_t capacity) {
+        size_t size = 1;
+        while (size < capacity) size <<= 1;
+        m_items.resize(size);
+        m_mask = size - 1;
+    }
+
+    // Producer side. Stores as many of the items as fit; returns how many.
+    size_t push(const T* items, size_t count) {
+        size_t tail = m_tail.load(std::memory_order_relaxed);
+        if (m_items.size() - (tail - m_cachedHead) < count) {
+            m_cachedHead = m_head.load(std::memory_order_acquire);
+        }
+        count = std::min(count, m_items.size() - (tail - m_cachedHead));
+        for (size_t i = 0; i < count; ++i) m_items[(tail + i) & m_mask] = items[i];
+        m_tail.store(tail + count, std::memory_order_release);
+        return count;
+    }
+
+    // Consumer side. Appends up to maxItems items to out; returns how many.
+    size_t pop(std::vector<T>& out, size_t maxItems) {
+        size_t head = m_head.load(std::memory_order_relaxed);
+        if (m_cachedTail - head < maxItems) m_cachedTail = m_tail.load(std::memory_order_acquire);
+        size_t count = std::min(maxItems, m_cachedTail - head);
+        for (size_t i = 0; i < count; ++i) out.push_back(m_items[(head + i) & m_mask]);
+        m_head.store(head + count, std::memory_order_release);
+        return count;
+    }
+
+    bool empty() const {
+        return m_head.load(std::memory_order_acquire) == m_tail.load(std::memory_order_acquire);
+    }
+
+    size_t capacity() const { return m_items.size(); }
+
+private:
+    std::vector<T> m_items;
+    size_t m_mask = 0;
+    alignas(64) std::atomic<size_t> m_head{0};
+    size_t m_cachedTail = 0;
+    alignas(64) std::atomic<size_t> m_tail{0};
+    size_t m_cachedHead = 0;
+};
+
+// One line of an edge stream. Node ids are the ids the graph shows (as in
+// matrix files), not dense indices.
+struct EdgeEvent {
+    uint32_t source = 0;
+    uint32_t target = 0;
+    bool remove = false;
+};
+
+// Reads edge events from a file, FIFO or stdin ("-") on its own thread and
+// hands them over through an SpscQueue. The format is one event per line:
+//
+//   + <source> <target>     insert (the '+' may be left out)
+//   - <source> <target>     delete
+//
+// Lines starting with '#' are comments; malformed lines are counted and
+// skipped. When the queue is full the reader waits, so a fast producer is
+// slowed down by the pipe rather than losing events.
+class EdgeStreamReader {
+public:
+    static constexpr size_t kQueueSize = 1 << 20;
+    static constexpr size_t kReadSize = 1 << 16;
+
+    ~EdgeStreamReader() { stop(); }
+
+    bool start(const std::string& path) {
+        std::FILE* file = path == "-" ? stdin : std::fopen(path.c_str(), "rb");
+        if (!file) {
+            std::cerr << "Failed to open edge stream: " << path << std::endl;
+            return false;
+        }
+        m_state = std::make_shared<State>();
+        m_thread = std::thread(readLoop, m_state, file, file != stdin);
+        return true;
+    }
+
+    // A reader blocked on an idle pipe cannot be woken portably, so it is
+    // left to exit on its own; it only touches state it shares ownership of.
+    void stop() {
+        if (!m_thread.joinable()) return;
+        m_state->stopping.store(true, std::memory_order_relaxed);
+        if (m_state->finished.load(std::memory_order_acquire)) m_thread.join();
+        else m_thread.detach();
+    }
+
+    // Appends up to maxEvents queued events; returns how many.
+    size_t poll(std::vector<EdgeEvent>& events, size_t maxEvents = SIZE_MAX) {
+        return m_state ? m_state->queue.pop(events, maxEvents) : 0;
+    }
+
+    bool isOpen() const { return m_state != nullptr; }
+
+    // True once the input ended and every event has been polled.
+    bool isFinished() const {
+        return m_state && m_state->finished.load(std::memory_order_acquire) && m_state->queue.empty();
+    }
+
+    uint64_t getEventCount() const { return m_state ? m_state->events.load(std::memory_order_relaxed) : 0; }
+    uint64_t getMalformedCount() const { return m_state ? m_state->malformed.load(std::memory_order_relaxed) : 0; }
+
+private:
+    struct State {
+        SpscQueue<EdgeEvent> queue{kQueueSize};
+        std::atomic<bool> stopping{false};
+        std::atomic<bool> finished{false};
+        std::atomic<uint64_t> events{0};
+        std::atomic<uint64_t> malformed{0};
+    };
+
+    std::shared_ptr<State> m_state;
+    std::thread m_thread;
+
+    static void readLoop(std::shared_ptr<State> state, std::FILE* file, bool owned) {
+        std::vector<char> buffer(kReadSize);
+        std::vector<EdgeEvent> parsed;
+        size_t kept = 0;
+        while (!state->stopping.load(std::memory_order_relaxed)) {
+            size_t read = readSome(file, buffer.data() + kept, buffer.size() - kept);
+            bool done = read == 0;
+            size_t end = kept + read;
+
+            // Only whole lines are parsed; the unfinished tail waits for the
+            // next read, unless the input has ended.
+            size_t lineEnd = end;
+            if (!done) {
+                while (lineEnd > 0 && buffer[lineEnd - 1] != '\n') --lineEnd;
+                if (lineEnd == 0 && end == buffer.size()) buffer.resize(buffer.size() * 2);
+            }
+            {
+                TRACE_ZONE("EdgeStreamReader::parse");
+                parsed.clear();
+                parseLines(buffer.data(), buffer.data() + lineEnd, parsed, *state);
+            }
+            kept = end - lineEnd;
+            std::memmove(buffer.data(), buffer.data() + lineEnd, kept);
+
+            size_t pushed = 0;
+            while (pushed < parsed.size() && !state->stopping.load(std::memory_order_relaxed)) {
+                size_t count = state->queue.push(parsed.data() + pushed, parsed.size() - pushed);
+                if (count == 0) std::this_thread::yield();
+                pushed += count;
+            }
+            state->events.fetch_add(pushed, std::memory_order_relaxed);
+            if (done) break;
+        }
+        if (owned) std::fclose(file);
+        state->finished.store(true, std::memory_order_release);
+    }
+
+    // Returns whatever a pipe has ready instead of waiting for a full
+    // buffer as fread would; 0 at end of input or on error.
+    static size_t readSome(std::FILE* file, char* data, size_t size) {
+#if defined(_WIN32)
+        int read = _read(_fileno(file), data, static_cast<unsigned>(std::min<size_t>(size, INT32_MAX)));
+#else
+        ssize_t read;
+        do {
+            read = ::read(fileno(file), data, size);
+        } while (read < 0 && errno == EINTR);
+#endif
+        return read > 0 ? static_cast<size_t>(read) : 0;
+    }
+
+    static void parseLines(const char* text, const char* end, std::vector<EdgeEvent>& events, State& state) {
+        while (text < end) {
+            const char* newline = static_cast<const char*>(std::memchr(text, '\n', end - text));
+            const char* lineEnd = newline ? newline : end;
+            const char* c = text;
+            text = newline ? newline + 1 : end;
+
+            auto skipSpace = [&]() {
+                while (c < lineEnd && (*c == ' ' || *c == '\t' || *c == '\r')) ++c;
+            };
+            skipSpace();
+            if (c == lineEnd || *c == '#') continue;
+
+            EdgeEvent event;
+            if (*c == '+' || *c == '-') {
+                event.remove = *c == '-';
+                ++c;
+                skipSpace();
+            }
+            auto first = std::from_chars(c, lineEnd, event.source);
+            c = first.ptr;
+            skipSpace();
+            auto second = std::from_chars(c, lineEnd, event.target);
+            if (first.ec != std::errc() || second.ec != std::errc()) {
+                state.malformed.fetch_add(1, std::memory_order_relaxed);
+                continue;
+            }
+            events.push_back(event);
+        }
+    }
+};
@@ -0,0 +1,236 @@
+#pragma once
+#include <SFML/Window.hpp>
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Text event logs for repeatable interaction benchmarks. The header records
+// the window size and the matrix file the session started from; each line
+// after it is "<microseconds since start> <kind> <fields...>". Only events
+// that affect the session are kept.
+//
+//   GraphVisualizer-events 1
+//   window 800 600
+//   input graph.txt
+//   120345 press 0 412 230
+//   135001 move 415 233
+struct EventLogHeader {
+    sf::Vector2u window{800, 600};
+    std::string input;
+};
+
+class EventRecorder {
+public:
+    bool open(const std::string& path, const EventLogHeader& header) {
+        m_file.open(path);
+        if (!m_file.is_open()) {
+            std::cerr << "Failed to open event log: " << path << std::endl;
+            return false;
+        }
+        m_file << "GraphVisualizer-events 1\nwindow " << header.window.x << ' ' << header.window.y << '\n';
+        if (!header.input.empty()) m_file << "input " << header.input << '\n';
+        return true;
+    }
+
+    bool isOpen() const { return m_file.is_open(); }
+
+    void record(uint64_t micros, const sf::Event& event) {
+        if (!m_file.is_open()) return;
+        switch (event.type) {
+            case sf::Event::Closed:
+                m_file << micros << " close\n";
+                break;
+            case sf::Event::Resized:
+                m_file << micros << " resize " << event.size.width << ' ' << event.size.height << '\n';
+                break;
+            case sf::Event::KeyPressed:
+            case sf::Event::KeyReleased:
+                m_file << micros << (event.type == sf::Event::KeyPressed ? " key " : " keyup ")
+                       << static_cast<int>(event.key.code) << ' ' << event.key.alt << ' ' << event.key.control << ' '
+                       << event.key.shift << ' ' << event.key.system << '\n';
+                break;
+            case sf::Event::MouseButtonPressed:
+            case sf::Event::MouseButtonReleased:
+                m_file << micros << (event.type == sf::Event::MouseButtonPressed ? " press " : " release ")
+                       << static_cast<int>(event.mouseButton.button) << ' ' << event.mouseButton.x << ' '
+                       << event.mouseButton.y << '\n';
+                break;
+            case sf::Event::MouseMoved:
+                m_file << micros << " move " << event.mouseMove.x << ' ' << event.mouseMove.y << '\n';
+                break;
+            default:
+                break;
+        }
+    }
+
+private:
+    std::ofstream m_file;
+};
+
+class EventReplayer {
+public:
+    bool open(const std::string& path) {
+        m_file.open(path);
+        std::string magic;
+        int version = 0;
+        if (!m_file.is_open() || !(m_file >> magic >> version) || magic != "GraphVisualizer-events" || version != 1) {
+            std::cerr << "Not an event log: " << path << std::endl;
+            return false;
+        }
+
+        std::string line;
+        std::getline(m_file, line);
+        while (m_file.peek() != EOF && !std::isdigit(m_file.peek())) {
+            std::getline(m_file, line);
+            std::istringstream fields(line);
+            std::string key;
+            fields >> key;
+            if (key == "window") fields >> m_header.window.x >> m_header.window.y;
+            else if (key == "input") std::getline(fields >> std::ws, m_header.input);
+        }
+        return true;
+    }
+
+    const EventLogHeader& getHeader() const { return m_header; }
+
+    // The next event and when it was recorded; false at the end of the log.
+    bool next(sf::Event& event, uint64_t& micros) {
+        std::string line;
+        while (std::getline(m_file, line)) {
+            std::istringstream fields(line);
+            std::string kind;
+            if (!(fields >> micros >> kind)) continue;
+
+            event = sf::Event();
+            int a = 0, b = 0, c = 0, d = 0, e = 0;
+            if (kind == "close") {
+                event.type = sf::Event::Closed;
+            } else if (kind == "resize" && fields >> a >> b) {
+                event.type = sf::Event::Resized;
+                event.size.width = static_cast<unsigned>(a);
+                event.size.height = static_cast<unsigned>(b);
+            } else if ((kind == "key" || kind == "keyup") && fields >> a >> b >> c >> d >> e) {
+                event.type = kind == "key" ? sf::Event::KeyPressed : sf::Event::KeyReleased;
+                event.key.code = static_cast<sf::Keyboard::Key>(a);
+                event.key.alt = b;
+                event.key.control = c;
+                event.key.shift = d;
+                event.key.system = e;
+            } else if ((kind == "press" || kind == "release") && fields >> a >> b >> c) {
+                event.type = kind == "press" ? sf::Event::MouseButtonPressed : sf::Event::MouseButtonReleased;
+                event.mouseButton.button = static_cast<sf::Mouse::Button>(a);
+                event.mouseButton.x = b;
+                event.mouseButton.y = c;
+            } else if (kind == "move" && fields >> a >> b) {
+                event.type = sf::Event::MouseMoved;
+                event.mouseMove.x = a;
+                event.mouseMove.y = b;
+            } else {
+                continue;
+            }
+            return true;
+        }
+        return false;
+    }
+
+    static std::string kindOf(const sf::Event& event) {
+        switch (event.type) {
+            case sf::Event::Closed: return "close";
+            case sf::Event::Resized: return "resize";
+            case sf::Event::KeyPressed: return "key";
+            case sf::Event::KeyReleased: return "keyup";
+            case sf::Event::MouseButtonPressed: return "press";
+            case sf::Event::MouseButtonReleased: return "release";
+            case sf::Event::MouseMoved: return "move";
+            default: return "other";
+        }
+    }
+
+private:
+    std::ifstream m_file;
+    EventLogHeader m_header;
+};
+
+// Per-event latencies of a replay: each event from dispatch until its
+// effects were handled (and, with a window, displayed).
+class LatencyReport {
+public:
+    void add(const std::string& kind, uint64_t recordedMicros, double latencyMicros) {
+        m_samples.push_back({kind, recordedMicros, latencyMicros});
+    }
+
+    // One row per event, for plotting or diffing two runs.
+    bool writeCsv(const std::string& path) const {
+        std::ofstream file(path);
+        if (!file.is_open()) {
+            std::cerr << "Failed to write latencies: " << path << std::endl;
+            return false;
+        }
+        file << "index,recorded_us,kind,latency_us\n";
+        for (size_t i = 0; i < m_samples.size(); ++i) {
+            file << i << ',' << m_samples[i].recorded << ',' << m_samples[i].kind << ',' << m_samples[i].latency << '\n';
+        }
+        return true;
+    }
+
+    // Count, mean, median, p95, p99 and max per event kind.
+    void printSummary(std::ostream& out) const {
+        std::vector<std::string> kinds;
+        for (const auto& sample : m_samples) {
+            if (std::find(kinds.begin(), kinds.end(), sample.kind) == kinds.end()) kinds.push_back(sample.kind);
+        }
+
+        out << "kind      count      mean_us       p50_us       p95_us       p99_us       max_us\n";
+        for (const auto& kind : kinds) {
+            std::vector<double> values;
+            for (const auto& sample : m_samples) {
+                if (sample.kind == kind) values.push_back(sample.latency);
+            }
+            std::sort(values.begin(), values.end());
+            double sum = 0.0;
+            for (double v : values) sum += v;
+            auto at = [&](double q) { return values[std::min(values.size() - 1, static_cast<size_t>(q * values.size()))]; };
+
+            char row[160];
+            std::snprintf(row, sizeof(row), "%-8s %6zu %12.1f %12.1f %12.1f %12.1f %12.1f\n", kind.c_str(),
+                          values.size(), sum / values.size(), at(0.5), at(0.95), at(0.99), values.back());
+            out << row;
+        }
+    }
+
+private:
+    struct Sample {
+        std::string kind;
+        uint64_t recorded;
+        double latency;
+    };
+    std::vector<Sample> m_samples;
+};
+
+// Feeds every event of a log to handle (which returns false to stop) and
+// records how long each took. With realtime set, events are spaced as
+// recorded; otherwise they run back to back.
+template <typename Handler>
+void replayEvents(EventReplayer& replayer, bool realtime, LatencyReport& report, Handler&& handle) {
+    using Clock = std::chrono::steady_clock;
+    const Clock::time_point start = Clock::now();
+    sf::Event event;
+    uint64_t micros = 0;
+    while (replayer.next(event, micros)) {
+        if (realtime) std::this_thread::sleep_until(start + std::chrono::microseconds(micros));
+
+        Clock::time_point dispatched = Clock::now();
+        bool keepGoing = handle(event);
+        std::chrono::duration<double, std::micro> latency = Clock::now() - dispatched;
+        report.add(EventReplayer::kindOf(event), micros, latency.count());
+        if (!keepGoing) break;
+    }
+}
@@ -0,0 +1,155 @@
+#pragma once
+#include "GraphView.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+struct ImageExportOptions {
+    // Output size in pixels; 0 means the graph's bounds at scale 1.
+    unsigned width = 0;
+    unsigned height = 0;
+    // Offscreen textures are capped by the GPU, so large images are drawn
+    // tile by tile and stitched together.
+    unsigned tileSize = 2048;
+    float margin = 40.f;
+    sf::Color background = sf::Color::White;
+};
+
+// World-space rectangle an export covers, and the image size it maps to.
+struct ExportFrame {
+    sf::FloatRect world;
+    unsigned width = 0;
+    unsigned height = 0;
+
+    static ExportFrame fit(const Graph& graph, const ImageExportOptions& options) {
+        sf::FloatRect bounds = graph.getBounds();
+        bounds.left -= options.margin;
+        bounds.top -= options.margin;
+        bounds.width += 2 * options.margin;
+        bounds.height += 2 * options.margin;
+
+        ExportFrame frame;
+        frame.width = options.width ? options.width : std::max(1u, static_cast<unsigned>(std::ceil(bounds.width)));
+        frame.height = options.height ? options.height : std::max(1u, static_cast<unsigned>(std::ceil(bounds.height)));
+
+        // Keep the aspect ratio: grow the world rect along the short side.
+        float scale = std::min(frame.width / bounds.width, frame.height / bounds.height);
+        sf::Vector2f size(frame.width / scale, frame.height / scale);
+        sf::Vector2f center(bounds.left + bounds.width / 2.f, bounds.top + bounds.height / 2.f);
+        frame.world = sf::FloatRect(center.x - size.x / 2.f, center.y - size.y / 2.f, size.x, size.y);
+        return frame;
+    }
+};
+
+// Renders the view's graph offscreen, one tile at a time, into a single
+// image. No window is needed; the stitched image is held in memory before
+// saving.
+inline bool exportPng(GraphView& view, const std::string& path, const ImageExportOptions& options = {}) {
+    ExportFrame frame = ExportFrame::fit(view.getGraph(), options);
+    unsigned tileSize = std::min(options.tileSize, sf::RenderTexture::getMaximumSize());
+    float unitsPerPixel = frame.world.width / frame.width;
+
+    sf::RenderTexture tile;
+    if (!tile.create(tileSize, tileSize)) {
+        std::cerr << "Failed to create offscreen render target" << std::endl;
+        return false;
+    }
+
+    sf::Image image;
+    image.create(frame.width, frame.height, options.background);
+
+    for (unsigned y = 0; y < frame.height; y += tileSize) {
+        for (unsigned x = 0; x < frame.width; x += tileSize) {
+            sf::View tileView(sf::FloatRect(frame.world.left + x * unitsPerPixel, frame.world.top + y * unitsPerPixel,
+                                        tileSize * unitsPerPixel, tileSize * unitsPerPixel));
+            tile.setView(tileView);
+            tile.clear(options.background);
+            view.drawGraph(tile);
+            tile.display();
+
+            unsigned w = std::min(tileSize, frame.width - x);
+            unsigned h = std::min(tileSize, frame.height - y);
+            image.copy(tile.getTexture().copyToImage(), x, y, sf::IntRect(0, 0, int(w), int(h)));
+        }
+    }
+
+    if (!image.saveToFile(path)) {
+        std::cerr << "Failed to write image: " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Writes SVG elements straight to the stream as it walks the graph, so
+// memory use does not grow with the number of nodes and edges.
+class SvgWriter {
+public:
+    explicit SvgWriter(std::ostream& out) : m_out(out) {}
+
+    void write(const Graph& graph, const ImageExportOptions& options = {}) {
+        ExportFrame frame = ExportFrame::fit(graph, options);
+        const NodeStore& nodes = graph.getNodes();
+
+        m_out << "<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"" << frame.width << "\" height=\""
+              << frame.height << "\" viewBox=\"" << frame.world.left << ' ' << frame.world.top << ' '
+              << frame.world.width << ' ' << frame.world.height << "\">\n";
+        m_out << "<rect x=\"" << frame.world.left << "\" y=\"" << frame.world.top << "\" width=\""
+              << frame.world.width << "\" height=\"" << frame.world.height << "\" fill=\""
+              << color(options.background) << "\"/>\n";
+
+        m_out << "<g stroke=\"" << color(BatchBuilder::edgeColor()) << "\" fill=\""
+              << color(BatchBuilder::edgeColor()) << "\">\n";
+        for (const Edge& edge : graph.getEdges()) {
+            EdgeGeometry geometry = EdgeGeometry::compute(nodes, edge);
+            if (!geometry.valid) continue;
+            m_out << "<line x1=\"" << geometry.lineStart.x << "\" y1=\"" << geometry.lineStart.y << "\" x2=\""
+                  << geometry.lineEnd.x << "\" y2=\"" << geometry.lineEnd.y << "\"/>\n";
+            if (geometry.hasArrow) writeArrow(geometry.arrowBase, geometry.arrowDirection);
+            if (geometry.hasReverseArrow) writeArrow(geometry.reverseBase, geometry.reverseDirection);
+        }
+        m_out << "</g>\n";
+
+        m_out << "<g stroke=\"black\" font-family=\"Arial\" font-size=\"" << BatchBuilder::kLabelSize
+              << "\" text-anchor=\"middle\" dominant-baseline=\"central\">\n";
+        for (size_t i = 0; i < nodes.size(); ++i) {
+            sf::Vector2f pos = nodes.getPosition(i);
+            float radius = nodes.getRadius(i);
+            float outline = radius * (nodes.isHighlighted(i) ? 0.1f : 0.05f);
+            m_out << "<circle cx=\"" << pos.x << "\" cy=\"" << pos.y << "\" r=\"" << radius << "\" fill=\""
+                  << color(nodes.getColor(i)) << "\" stroke-width=\"" << outline << "\"/>\n";
+            m_out << "<text x=\"" << pos.x << "\" y=\"" << pos.y << "\" stroke=\"none\">"
+                  << nodes.getId(i) << "</text>\n";
+        }
+        m_out << "</g>\n</svg>\n";
+    }
+
+private:
+    std::ostream& m_out;
+
+    void writeArrow(const sf::Vector2f& base, const sf::Vector2f& direction) {
+        sf::Vector2f corners[3];
+        EdgeGeometry::arrowCorners(base, direction, corners);
+        m_out << "<polygon points=\"";
+        for (const sf::Vector2f& corner : corners) m_out << corner.x << ',' << corner.y << ' ';
+        m_out << "\"/>\n";
+    }
+
+    static std::string color(const sf::Color& c) {
+        char buffer[8];
+        std::snprintf(buffer, sizeof(buffer), "#%02x%02x%02x", c.r, c.g, c.b);
+        return buffer;
+    }
+};
+
+inline bool exportSvg(const Graph& graph, const std::string& path, const ImageExportOptions& options = {}) {
+    std::ofstream file(path);
+    if (!file.is_open()) {
+        std::cerr << "Failed to write image: " << path << std::endl;
+        return false;
+    }
+    SvgWriter(file).write(graph, options);
+    return static_cast<bool>(file);
+}
@@ -0,0 +1,364 @@
+#pragma once
+#include "Parallel.hpp"
+#include "Trace.hpp"
+#include <SFML/System/Vector2.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+using EdgeChunk = std::vector<std::pair<uint32_t, uint32_t>>;
+using EdgeSink = std::function<void(const EdgeChunk&)>;
+
+// What to generate, parsed from "kind:key=value,...", e.g. "gnp:n=100000,p=0.0001".
+//
+//   gnp   n, p              Erdős–Rényi G(n, p)
+//   gnm   n, m              Erdős–Rényi G(n, m), exactly m distinct edges
+//   ba    n, d              Barabási–Albert, d edges per new node
+//   rmat  scale, edges, a, b, c    R-MAT / Kronecker on 2^scale nodes
+//   grid  rows, cols        4-neighbour lattice
+//   rgg   n, radius         random geometric graph in the unit square
+struct GeneratorSpec {
+    std::string kind;
+    size_t n = 0;
+    double p = 0.0;
+    size_t m = 0;
+    size_t d = 2;
+    unsigned scale = 10;
+    double a = 0.57, b = 0.19, c = 0.19;
+    size_t rows = 0, cols = 0;
+    double radius = 0.0;
+    uint64_t seed = 1;
+
+    static bool parse(const std::string& text, GeneratorSpec& spec) {
+        size_t colon = text.find(':');
+        spec.kind = text.substr(0, colon);
+        std::istringstream fields(colon == std::string::npos ? "" : text.substr(colon + 1));
+        std::string field;
+        while (std::getline(fields, field, ',')) {
+            size_t equals = field.find('=');
+            if (equals == std::string::npos) {
+                std::cerr << "Expected key=value in generator spec: " << field << std::endl;
+                return false;
+            }
+            std::string key = field.substr(0, equals);
+            double value = std::atof(field.c_str() + equals + 1);
+            if (key == "n") spec.n = static_cast<size_t>(value);
+            else if (key == "p") spec.p = value;
+            else if (key == "m" || key == "edges") spec.m = static_cast<size_t>(value);
+            else if (key == "d") spec.d = static_cast<size_t>(value);
+            else if (key == "scale") spec.scale = static_cast<unsigned>(value);
+            else if (key == "a") spec.a = value;
+            else if (key == "b") spec.b = value;
+            else if (key == "c") spec.c = value;
+            else if (key == "rows") spec.rows = static_cast<size_t>(value);
+            else if (key == "cols") spec.cols = static_cast<size_t>(value);
+            else if (key == "radius") spec.radius = value;
+            else if (key == "seed") spec.seed = static_cast<uint64_t>(value);
+            else {
+                std::cerr << "Unknown generator parameter: " << key << std::endl;
+                return false;
+            }
+        }
+        if (spec.kind == "grid") spec.n = spec.rows * spec.cols;
+        if (spec.kind == "rmat") spec.n = size_t(1) << spec.scale;
+
+        static const char* kinds[] = {"gnp", "gnm", "ba", "rmat", "grid", "rgg"};
+        if (std::find(std::begin(kinds), std::end(kinds), spec.kind) == std::end(kinds)) {
+            std::cerr << "Unknown generator: " << spec.kind << std::endl;
+            return false;
+        }
+        if (spec.n == 0 || spec.n > UINT32_MAX) {
+            std::cerr << "Generator needs between 1 and 2^32 - 1 nodes" << std::endl;
+            return false;
+        }
+        return true;
+    }
+};
+
+// Generates graphs in blocks. Each block draws from its own generator seeded
+// by (seed, block), and blocks are handed to the sink in order, so the
+// output depends only on the spec and seed, never on the thread count.
+// Blocks are built a wave (one per worker) at a time, which bounds memory
+// however many edges are produced. All generators except rmat and ba emit
+// each undirected edge once, as (smaller, larger); those two may repeat
+// edges or produce self loops, which Graph::addEdges drops.
+class GraphGenerator {
+public:
+    static constexpr size_t kBlockEdges = 1 << 18;
+
+    explicit GraphGenerator(const GeneratorSpec& spec) : m_spec(spec) {}
+
+    size_t nodeCount() const { return m_spec.n; }
+
+    // Positions for generators that have them (grid, rgg), about spacing
+    // apart; empty otherwise.
+    std::vector<sf::Vector2f> positions(float spacing = 60.f) const {
+        std::vector<sf::Vector2f> result;
+        if (m_spec.kind == "grid") {
+            result.resize(m_spec.n);
+            for (size_t i = 0; i < m_spec.n; ++i) {
+                result[i] = sf::Vector2f((i % m_spec.cols) * spacing, (i / m_spec.cols) * spacing);
+            }
+        } else if (m_spec.kind == "rgg") {
+            result = rggPoints();
+            float extent = spacing * std::sqrt(static_cast<float>(m_spec.n));
+            for (auto& p : result) p *= extent;
+        }
+        return result;
+    }
+
+    void run(const EdgeSink& sink) const {
+        TRACE_ZONE("GraphGenerator::run");
+        if (m_spec.kind == "gnp") gnp(sink);
+        else if (m_spec.kind == "gnm") gnm(sink);
+        else if (m_spec.kind == "ba") barabasiAlbert(sink);
+        else if (m_spec.kind == "rmat") rmat(sink);
+        else if (m_spec.kind == "grid") grid(sink);
+        else if (m_spec.kind == "rgg") rgg(sink);
+    }
+
+private:
+    GeneratorSpec m_spec;
+
+    static uint64_t mix(uint64_t x) {
+        x += 0x9e3779b97f4a7c15ull;
+        x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+        x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+        return x ^ (x >> 31);
+    }
+
+    std::mt19937_64 blockRng(uint64_t block) const {
+        return std::mt19937_64(mix(m_spec.seed * 0x100000001b3ull + block));
+    }
+
+    template <typename Fn>
+    static void generateBlocks(size_t blockCount, const EdgeSink& sink, Fn&& fill) {
+        const size_t wave = workerCount();
+        std::vector<EdgeChunk> chunks(std::min(wave, std::max<size_t>(blockCount, 1)));
+        for (size_t first = 0; first < blockCount; first += wave) {
+            size_t count = std::min(wave, blockCount - first);
+            parallelFor(count, [&](size_t begin, size_t end, unsigned) {
+                for (size_t i = begin; i < end; ++i) {
+                    chunks[i].clear();
+                    fill(first + i, chunks[i]);
+                }
+            }, 1);
+            for (size_t i = 0; i < count; ++i) sink(chunks[i]);
+        }
+    }
+
+    // Pair k of the upper triangle (row-major, i < j) of an n x n matrix.
+    static std::pair<uint32_t, uint32_t> pairAt(uint64_t k, uint64_t n) {
+        double b = 2.0 * n - 1.0;
+        uint64_t i = static_cast<uint64_t>((b - std::sqrt(b * b - 8.0 * k)) / 2.0);
+        auto rowStart = [n](uint64_t row) { return row * (2 * n - row - 1) / 2; };
+        while (i > 0 && rowStart(i) > k) --i;
+        while (rowStart(i + 1) <= k) ++i;
+        return {static_cast<uint32_t>(i), static_cast<uint32_t>(i + 1 + (k - rowStart(i)))};
+    }
+
+    // Blocks of pair indices; each block skips ahead by geometric gaps
+    // (Batagelj and Brandes), so the cost follows the edges, not n^2.
+    void gnp(const EdgeSink& sink) const {
+        const uint64_t n = m_spec.n;
+        const uint64_t pairs = n * (n - 1) / 2;
+        const double p = std::min(1.0, std::max(0.0, m_spec.p));
+        if (p <= 0.0 || pairs == 0) return;
+        double expectedSpan = kBlockEdges / p;
+        uint64_t span = expectedSpan >= pairs ? pairs : std::max<uint64_t>(1, static_cast<uint64_t>(expectedSpan));
+        generateBlocks((pairs + span - 1) / span, sink, [&](size_t block, EdgeChunk& out) {
+            std::mt19937_64 rng = blockRng(block);
+            std::uniform_real_distribution<double> uniform(0.0, 1.0);
+            uint64_t k = block * span;
+            uint64_t end = std::min(pairs, k + span);
+            double logq = std::log1p(-p);
+            while (true) {
+                if (p < 1.0) k += static_cast<uint64_t>(std::floor(std::log1p(-uniform(rng)) / logq));
+                if (k >= end) break;
+                out.push_back(pairAt(k, n));
+                ++k;
+            }
+        });
+    }
+
+    // Exactly m distinct pairs: the pair index space is cut into ranges,
+    // a multinomial split (drawn in order from the seed) decides how many
+    // edges each range gets, and each range samples that many distinct
+    // indices with Floyd's algorithm. Each draw is clamped so the range can
+    // hold it and the ranges after it can hold the rest, which keeps the
+    // total at m when m comes close to the number of pairs.
+    void gnm(const EdgeSink& sink) const {
+        const uint64_t n = m_spec.n;
+        const uint64_t pairs = n * (n - 1) / 2;
+        uint64_t m = std::min<uint64_t>(m_spec.m, pairs);
+        if (m == 0) return;
+        size_t ranges = static_cast<size_t>((m + kBlockEdges - 1) / kBlockEdges);
+        uint64_t span = (pairs + ranges - 1) / ranges;
+
+        std::vector<uint64_t> counts(ranges);
+        std::mt19937_64 rng = blockRng(UINT64_MAX);
+        uint64_t remainingPairs = pairs;
+        uint64_t remainingEdges = m;
+        for (size_t r = 0; r < ranges; ++r) {
+            uint64_t size = std::min(span, pairs - r * span);
+            uint64_t least = remainingEdges > remainingPairs - size ? remainingEdges - (remainingPairs - size) : 0;
+            counts[r] = remainingEdges == 0 ? 0
+                        : r + 1 == ranges ? remainingEdges
+                        : std::binomial_distribution<uint64_t>(remainingEdges, double(size) / remainingPairs)(rng);
+            counts[r] = std::max(least, std::min(counts[r], std::min(size, remainingEdges)));
+            remainingEdges -= counts[r];
+            remainingPairs -= size;
+        }
+
+        generateBlocks(ranges, sink, [&](size_t range, EdgeChunk& out) {
+            std::mt19937_64 blockGen = blockRng(range);
+            uint64_t first = range * span;
+            uint64_t size = std::min(span, pairs - first);
+            std::unordered_set<uint64_t> chosen;
+            chosen.reserve(counts[range] * 2);
+            for (uint64_t j = size - counts[range]; j < size; ++j) {
+                uint64_t t = std::uniform_int_distribution<uint64_t>(0, j)(blockGen);
+                if (!chosen.insert(t).second) chosen.insert(j);
+            }
+            std::vector<uint64_t> sorted(chosen.begin(), chosen.end());
+            std::sort(sorted.begin(), sorted.end());
+            out.reserve(sorted.size());
+            for (uint64_t k : sorted) out.push_back(pairAt(first + k, n));
+        });
+    }
+
+    // Preferential attachment without a sequential pass (Sanders and
+    // Schulz): edge e of node e / d picks a uniform earlier endpoint slot.
+    // An even slot is a known source node; an odd one is the target of an
+    // earlier edge, resolved the same way. Every choice is a hash of
+    // (seed, slot), so edges resolve independently in any order.
+    void barabasiAlbert(const EdgeSink& sink) const {
+        const uint64_t d = std::max<size_t>(1, m_spec.d);
+        const uint64_t edges = m_spec.n * d;
+        auto target = [&](uint64_t e) {
+            while (true) {
+                uint64_t slot = mix(m_spec.seed ^ mix(e)) % (2 * e + 1);
+                if (slot % 2 == 0) return static_cast<uint32_t>(slot / 2 / d);
+                e = slot / 2;
+            }
+        };
+        generateBlocks((edges + kBlockEdges - 1) / kBlockEdges, sink, [&](size_t block, EdgeChunk& out) {
+            uint64_t first = block * kBlockEdges;
+            uint64_t last = std::min(edges, first + kBlockEdges);
+            out.reserve(last - first);
+            for (uint64_t e = first; e < last; ++e) {
+                out.emplace_back(static_cast<uint32_t>(e / d), target(e));
+            }
+        });
+    }
+
+    // Each edge descends `scale` levels, picking a quadrant with
+    // probabilities a, b, c and 1 - a - b - c.
+    void rmat(const EdgeSink& sink) const {
+        const uint64_t edges = m_spec.m;
+        generateBlocks((edges + kBlockEdges - 1) / kBlockEdges, sink, [&](size_t block, EdgeChunk& out) {
+            std::mt19937_64 rng = blockRng(block);
+            std::uniform_real_distribution<double> uniform(0.0, 1.0);
+            uint64_t count = std::min<uint64_t>(kBlockEdges, edges - block * kBlockEdges);
+            out.reserve(count);
+            for (uint64_t e = 0; e < count; ++e) {
+                uint32_t u = 0, v = 0;
+                for (unsigned level = 0; level < m_spec.scale; ++level) {
+                    double r = uniform(rng);
+                    bool right = r >= m_spec.a && (r < m_spec.a + m_spec.b || r >= m_spec.a + m_spec.b + m_spec.c);
+                    bool down = r >= m_spec.a + m_spec.b;
+                    u = (u << 1) | down;
+                    v = (v << 1) | right;
+                }
+                out.emplace_back(u, v);
+            }
+        });
+    }
+
+    void grid(const EdgeSink& sink) const {
+        const size_t rows = m_spec.rows, cols = m_spec.cols;
+        size_t rowsPerBlock = std::max<size_t>(1, kBlockEdges / std::max<size_t>(1, 2 * cols));
+        generateBlocks((rows + rowsPerBlock - 1) / rowsPerBlock, sink, [&](size_t block, EdgeChunk& out) {
+            size_t last = std::min(rows, (block + 1) * rowsPerBlock);
+            for (size_t r = block * rowsPerBlock; r < last; ++r) {
+                for (size_t c = 0; c < cols; ++c) {
+                    uint32_t u = static_cast<uint32_t>(r * cols + c);
+                    if (c + 1 < cols) out.emplace_back(u, u + 1);
+                    if (r + 1 < rows) out.emplace_back(u, static_cast<uint32_t>(u + cols));
+                }
+            }
+        });
+    }
+
+    std::vector<sf::Vector2f> rggPoints() const {
+        std::vector<sf::Vector2f> points(m_spec.n);
+        size_t blocks = (m_spec.n + kBlockEdges - 1) / kBlockEdges;
+        parallelFor(blocks, [&](size_t begin, size_t end, unsigned) {
+            for (size_t block = begin; block < end; ++block) {
+                std::mt19937_64 rng = blockRng(block);
+                std::uniform_real_distribution<float> uniform(0.f, 1.f);
+                size_t last = std::min(m_spec.n, (block + 1) * kBlockEdges);
+                for (size_t i = block * kBlockEdges; i < last; ++i) points[i] = sf::Vector2f(uniform(rng), uniform(rng));
+            }
+        }, 1);
+        return points;
+    }
+
+    // Points are bucketed into cells of side radius; each cell only checks
+    // itself and the four neighbouring cells ahead of it.
+    void rgg(const EdgeSink& sink) const {
+        std::vector<sf::Vector2f> points = rggPoints();
+        const float radius = static_cast<float>(m_spec.radius);
+        if (radius <= 0.f) return;
+        // Cells at least radius wide, and no more cells than points.
+        const size_t side = std::max<size_t>(1, std::min(static_cast<size_t>(1.f / radius),
+                                                         static_cast<size_t>(std::sqrt(double(points.size())))));
+        auto cellOf = [&](const sf::Vector2f& p) {
+            size_t x = std::min(side - 1, static_cast<size_t>(p.x * side));
+            size_t y = std::min(side - 1, static_cast<size_t>(p.y * side));
+            return y * side + x;
+        };
+
+        std::vector<uint32_t> cellStart(side * side + 1, 0);
+        for (const auto& p : points) ++cellStart[cellOf(p) + 1];
+        for (size_t i = 0; i < side * side; ++i) cellStart[i + 1] += cellStart[i];
+        std::vector<uint32_t> items(points.size());
+        std::vector<uint32_t> cursor(cellStart.begin(), cellStart.end() - 1);
+        for (uint32_t i = 0; i < points.size(); ++i) items[cursor[cellOf(points[i])]++] = i;
+
+        const float radiusSquared = radius * radius;
+        size_t rowsPerBlock = std::max<size_t>(1, side / (4 * workerCount()));
+        generateBlocks((side + rowsPerBlock - 1) / rowsPerBlock, sink, [&](size_t block, EdgeChunk& out) {
+            size_t lastRow = std::min(side, (block + 1) * rowsPerBlock);
+            for (size_t cy = block * rowsPerBlock; cy < lastRow; ++cy) {
+                for (size_t cx = 0; cx < side; ++cx) {
+                    size_t cell = cy * side + cx;
+                    const int offsets[5][2] = {{0, 0}, {1, 0}, {-1, 1}, {0, 1}, {1, 1}};
+                    for (const auto& offset : offsets) {
+                        long nx = static_cast<long>(cx) + offset[0];
+                        long ny = static_cast<long>(cy) + offset[1];
+                        if (nx < 0 || nx >= static_cast<long>(side) || ny >= static_cast<long>(side)) continue;
+                        size_t other = ny * side + nx;
+                        for (uint32_t a = cellStart[cell]; a < cellStart[cell + 1]; ++a) {
+                            uint32_t b = other == cell ? a + 1 : cellStart[other];
+                            for (; b < cellStart[other + 1]; ++b) {
+                                sf::Vector2f delta = points[items[a]] - points[items[b]];
+                                if (delta.x * delta.x + delta.y * delta.y > radiusSquared) continue;
+                                out.emplace_back(std::min(items[a], items[b]), std::max(items[a], items[b]));
+                            }
+                        }
+                    }
+                }
+            }
+        });
+    }
+};
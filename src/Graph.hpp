@@ -1,91 +1,60 @@
 #pragma once
 #include "Node.hpp"
 #include "Edge.hpp"
+#include "Csr.hpp"
+#include "EdgeList.hpp"
+#include "EdgeStream.hpp"
+#include "KeyIndex.hpp"
+#include "Memory.hpp"
+#include "PageRank.hpp"
+#include "Centrality.hpp"
+#include "Louvain.hpp"
+#include "MultilevelLayout.hpp"
+#include "OverlapRemoval.hpp"
+#include "SegmentIndex.hpp"
+#include "StressLayout.hpp"
+#include "Triangles.hpp"
+#include "Trace.hpp"
 #include <vector>
-#include <memory>
 #include <fstream>
 #include <sstream>
 #include <SFML/Graphics.hpp>
 #include <set>
 #include <algorithm>>
+#include <limits>
+#include <utility>
 
 class Graph {
 public:
-    Graph(sf::RenderWindow& window, const sf::Font& font, const std::string& matrixFilePath)
-        : m_window(&window), m_font(font), m_nextNodeId(0),
-          m_matrixFilePath(matrixFilePath), m_isOriented(false) {
-        initializeUI();
-        updateAdjacencyMatrix();
-    }
-
-    void initializeUI() {
-
-        m_orientationToggle.setRadius(15.f);
-        m_orientationToggle.setPosition(10.f, 10.f);
-        m_orientationToggle.setFillColor(sf::Color::White);
-        m_orientationToggle.setOutlineColor(sf::Color::Black);
-        m_orientationToggle.setOutlineThickness(2.f);
-
-
-        m_toggleText.setFont(m_font);
-        m_toggleText.setString("U");
-        m_toggleText.setCharacterSize(20);
-        m_toggleText.setFillColor(sf::Color::Black);
-        centerText(m_toggleText, m_orientationToggle.getPosition() +
-            sf::Vector2f(m_orientationToggle.getRadius(), m_orientationToggle.getRadius()));
-
-
-        m_helpText.setFont(m_font);
-        m_helpText.setString("Click to toggle orientation (U/D)");
-        m_helpText.setCharacterSize(17);
-        m_helpText.setFillColor(sf::Color::Black);
-        m_helpText.setPosition( 45.f, 14.f);
-
-
-        m_modeText.setFont(m_font);
-        m_modeText.setCharacterSize(17);
-        m_modeText.setFillColor(sf::Color::Black);
-        m_modeText.setPosition(10.f, 570.f);
-        updateModeText(false);
-    }
-
-    bool handleToggleClick(const sf::Vector2f& mousePos) {
-        sf::Vector2f togglePos = m_orientationToggle.getPosition();
-        sf::Vector2f toggleCenter = togglePos +
-            sf::Vector2f(m_orientationToggle.getRadius(), m_orientationToggle.getRadius());
-
-        float distance = std::sqrt(
-            std::pow(mousePos.x - toggleCenter.x, 2) +
-            std::pow(mousePos.y - toggleCenter.y, 2)
-        );
-
-        if (distance <= m_orientationToggle.getRadius()) {
-            toggleOrientation();
-            return true;
-        }
-        return false;
-    }
-
-    void updateModeText(bool isDrawingMode) {
-        m_modeText.setString(isDrawingMode ? "Drawing Mode (press D to change)" : "Movement Mode (press D to change)");
+    // The graph model: nodes, edges, adjacency, persistence, analytics and
+    // layout. Drawing lives in GraphView, so batch jobs use this on its own.
+    // An empty path turns matrix persistence off.
+    explicit Graph(const std::string& matrixFilePath)
+        : m_nextNodeId(0), m_matrixFilePath(matrixFilePath), m_isOriented(false) {
+        writeMatrixToFile();
     }
 
     void addNode(const sf::Vector2f& position) {
+        TRACE_ZONE("Graph::addNode");
         const float minDistance = 44.0f;
 
         if (isPositionValid(position, minDistance)) {
-            auto newNode = std::make_unique<Node>(++m_nextNodeId, position, m_font);
-            m_nodes.push_back(std::move(newNode));
-            updateAdjacencyMatrix();
+            stopLayoutRefinement();
+            NodeHandle handle = m_nodes.add(++m_nextNodeId, position);
+            indexNodeId(handle);
+            if (m_nodeIndexBuilt) indexNode(handle);
+            m_incidentEdges.emplace_back();
+            commitChanges();
         }
     }
 
-    void addEdge(Node* start, Node* end) {
+    void addEdge(NodeHandle start, NodeHandle end) {
+        TRACE_ZONE("Graph::addEdge");
         if (!nodeExists(start) || !nodeExists(end)) return;
+        stopLayoutRefinement();
 
-
-        auto existingEdge = findEdge(start, end);
-        auto reverseEdge = findEdge(end, start);
+        Edge* existingEdge = findEdge(start, end);
+        Edge* reverseEdge = findEdge(end, start);
 
         if (m_isOriented) {
             if (existingEdge) {
@@ -93,15 +62,11 @@ public:
                 return;
             } else if (reverseEdge) {
 
-                auto newEdge = std::make_unique<Edge>(start, end, true);
-
                 reverseEdge->setBidirectional(true);
-                newEdge->setBidirectional(true);
-                m_edges.push_back(std::move(newEdge));
+                linkEdge(m_edges.insert(Edge(start, end, true, true)));
             } else {
 
-                auto newEdge = std::make_unique<Edge>(start, end, true);
-                m_edges.push_back(std::move(newEdge));
+                linkEdge(m_edges.insert(Edge(start, end, true)));
             }
         } else {
 
@@ -110,40 +75,234 @@ public:
                 return;
             } else {
 
-                auto newEdge = std::make_unique<Edge>(start, end, false);
-                m_edges.push_back(std::move(newEdge));
+                linkEdge(m_edges.insert(Edge(start, end, false)));
+            }
+        }
+
+        ++m_edgeVersion;
+        commitEdgeChange(start, end, true);
+    }
+
+    // Removes the edge in O(degree) of its endpoints. In an undirected graph
+    // the edge may be given either way round; in an oriented one only
+    // start -> end goes, and a reverse edge stops being bidirectional.
+    bool removeEdge(NodeHandle start, NodeHandle end) {
+        EdgeHandle handle = findEdgeHandle(start, end);
+        if (!handle && !m_isOriented) handle = findEdgeHandle(end, start);
+        return removeEdge(handle);
+    }
+
+    bool removeEdge(EdgeHandle handle) {
+        TRACE_ZONE("Graph::removeEdge");
+        const Edge* edge = std::as_const(m_edges).get(handle);
+        if (!edge) return false;
+        stopLayoutRefinement();
+        NodeHandle start = edge->getFirst();
+        NodeHandle end = edge->getSecond();
+        eraseEdge(handle);
+        commitEdgeChange(start, end, false);
+        return true;
+    }
+
+    // Removes the node and its incident edges in O(degree): each edge is
+    // unhooked from the other endpoint's incident list, and the node's slot
+    // in the node store and incident lists is filled from the back.
+    bool removeNode(NodeHandle handle) {
+        TRACE_ZONE("Graph::removeNode");
+        int64_t i = m_nodes.indexOf(handle);
+        if (i < 0) return false;
+        stopLayoutRefinement();
+        if (handle == m_dynamicNode) m_dynamicNode = NodeHandle();
+
+        for (EdgeHandle edgeHandle : m_incidentEdges[i]) {
+            const Edge* edge = std::as_const(m_edges).get(edgeHandle);
+            NodeHandle other = edge->getFirst() == handle ? edge->getSecond() : edge->getFirst();
+            if (other != handle) eraseIncident(other, edgeHandle);
+            if (m_edgeKeysBuilt) m_edgeKeys.erase(edgeKey(edge->getFirst(), edge->getSecond()));
+            if (m_edgeIndexBuilt) m_edgeIndex.remove(edgeHandle.index());
+            m_edges.remove(edgeHandle);
+        }
+
+        if (m_handlesByIdBuilt) m_handlesById.erase(m_nodes.getId(i));
+        if (m_nodeIndexBuilt) m_nodeIndex.remove(handle.index());
+        size_t last = m_nodes.size() - 1;
+        m_nodes.remove(handle);
+        m_incidentEdges[i] = std::move(m_incidentEdges[last]);
+        m_incidentEdges.pop_back();
+        ++m_edgeVersion;
+        // The matrix changes shape, so the file is rewritten.
+        commitChanges();
+        return true;
+    }
+
+    // Adds one node per position and returns their handles. Spacing is only
+    // checked when validate is set (against existing and earlier accepted
+    // nodes, O(n) each); rejected positions get an invalid handle.
+    std::vector<NodeHandle> addNodes(const std::vector<sf::Vector2f>& positions, bool validate = false) {
+        TRACE_ZONE("Graph::addNodes");
+        const float minDistance = 44.0f;
+        std::vector<NodeHandle> handles(positions.size());
+        if (positions.empty()) return handles;
+
+        Batch batch(*this);
+        stopLayoutRefinement();
+        m_nodes.reserve(m_nodes.size() + positions.size());
+        m_incidentEdges.reserve(m_incidentEdges.size() + positions.size());
+        for (size_t i = 0; i < positions.size(); ++i) {
+            if (validate && !isPositionValid(positions[i], minDistance)) continue;
+            handles[i] = m_nodes.add(++m_nextNodeId, positions[i]);
+            indexNodeId(handles[i]);
+            if (m_nodeIndexBuilt) indexNode(handles[i]);
+            m_incidentEdges.emplace_back();
+        }
+        markDirty();
+        return handles;
+    }
+
+    // Adds many edges at once. Pairs are sorted and deduplicated (against
+    // each other and the existing edges) up front; self loops and unknown
+    // handles are dropped. In an oriented graph a pair whose reverse exists
+    // becomes bidirectional, as with addEdge. Returns the number added.
+    size_t addEdges(const std::vector<std::pair<NodeHandle, NodeHandle>>& pairs) {
+        TRACE_ZONE("Graph::addEdges");
+        using Key = std::pair<uint32_t, uint32_t>;
+        auto key = [this](int64_t a, int64_t b) {
+            if (!m_isOriented && a > b) std::swap(a, b);
+            return Key(static_cast<uint32_t>(a), static_cast<uint32_t>(b));
+        };
+
+        std::vector<Key> added;
+        added.reserve(pairs.size());
+        for (const auto& pair : pairs) {
+            int64_t a = m_nodes.indexOf(pair.first);
+            int64_t b = m_nodes.indexOf(pair.second);
+            if (a < 0 || b < 0 || a == b) continue;
+            added.push_back(key(a, b));
+        }
+        std::sort(added.begin(), added.end());
+        added.erase(std::unique(added.begin(), added.end()), added.end());
+
+        std::vector<Key> existing;
+        existing.reserve(m_edges.size());
+        for (const Edge& edge : std::as_const(m_edges)) {
+            existing.push_back(key(m_nodes.indexOf(edge.getFirst()), m_nodes.indexOf(edge.getSecond())));
+        }
+        std::sort(existing.begin(), existing.end());
+        added.erase(std::remove_if(added.begin(), added.end(), [&](const Key& k) {
+            return std::binary_search(existing.begin(), existing.end(), k);
+        }), added.end());
+        if (added.empty()) return 0;
+
+        Batch batch(*this);
+        stopLayoutRefinement();
+        m_edges.reserve(m_edges.size() + added.size());
+        for (const Key& k : added) {
+            Key reverse(k.second, k.first);
+            bool bidirectional = m_isOriented &&
+                (std::binary_search(added.begin(), added.end(), reverse) ||
+                 std::binary_search(existing.begin(), existing.end(), reverse));
+            NodeHandle start = m_nodes.handleAt(k.first);
+            NodeHandle end = m_nodes.handleAt(k.second);
+            if (bidirectional && std::binary_search(existing.begin(), existing.end(), reverse)) {
+                findEdge(end, start)->setBidirectional(true);
             }
+            linkEdge(m_edges.insert(Edge(start, end, m_isOriented, bidirectional)));
         }
 
-        updateAdjacencyMatrix();
+        ++m_edgeVersion;
+        markDirty();
+        return added.size();
+    }
+
+    // Defers matrix file maintenance until the outermost
+    // Batch on this graph goes out of scope, so a run of addNode / addEdge
+    // calls (or of the bulk variants) pays for it once.
+    class Batch {
+    public:
+        explicit Batch(Graph& graph) : m_graph(graph) { ++m_graph.m_batchDepth; }
+        ~Batch() {
+            if (--m_graph.m_batchDepth == 0 && m_graph.m_matrixFileDirty) m_graph.writeMatrixToFile();
+        }
+        Batch(const Batch&) = delete;
+        Batch& operator=(const Batch&) = delete;
+
+    private:
+        Graph& m_graph;
+    };
+
+    // Applies a run of streamed edge events as one batch. Nodes are found by
+    // id and created on first mention, next to the other endpoint when it
+    // already exists. Inserting an existing edge or deleting a missing one
+    // does nothing. Returns the number of events that changed the graph.
+    size_t applyEdgeEvents(const std::vector<EdgeEvent>& events) {
+        TRACE_ZONE("Graph::applyEdgeEvents");
+        if (events.empty()) return 0;
+        Batch batch(*this);
+        stopLayoutRefinement();
+        if (!m_handlesByIdBuilt) {
+            m_handlesById.reserve(m_nodes.size());
+            for (size_t i = 0; i < m_nodes.size(); ++i) m_handlesById.insert(m_nodes.getId(i), m_nodes.handleAt(i).value);
+            m_handlesByIdBuilt = true;
+        }
+        if (!m_edgeKeysBuilt) {
+            m_edgeKeys.reserve(m_edges.size());
+            for (size_t i = 0; i < m_edges.size(); ++i) {
+                const Edge& edge = std::as_const(m_edges)[i];
+                m_edgeKeys.insert(edgeKey(edge.getFirst(), edge.getSecond()), m_edges.handleAt(i).value);
+            }
+            m_edgeKeysBuilt = true;
+        }
+
+        size_t applied = 0;
+        for (const EdgeEvent& event : events) {
+            if (event.remove) {
+                NodeHandle start = findNodeById(event.source);
+                NodeHandle end = findNodeById(event.target);
+                EdgeHandle edge = findEdgeHandle(start, end);
+                if (!edge && !m_isOriented) edge = findEdgeHandle(end, start);
+                if (!edge) continue;
+                eraseEdge(edge);
+                markDirty();
+                ++applied;
+            } else {
+                if (event.source == event.target) continue;
+                NodeHandle start = streamNode(event.source, NodeHandle());
+                NodeHandle end = streamNode(event.target, start);
+                size_t before = m_edges.size();
+                addEdge(start, end);
+                applied += m_edges.size() != before;
+            }
+        }
+        return applied;
     }
 
     void toggleOrientation() {
         m_isOriented = !m_isOriented;
-        updateToggleAppearance();
+        stopLayoutRefinement();
 
         if (m_isOriented) {
 
-            for (const auto& edge : m_edges) {
-                edge->setOriented(true);
+            for (auto& edge : m_edges) {
+                edge.setOriented(true);
 
 
-                auto reverseEdge = findEdge(edge->getSecond(), edge->getFirst());
+                auto reverseEdge = findEdge(edge.getSecond(), edge.getFirst());
                 if (reverseEdge) {
-                    edge->setBidirectional(true);
+                    edge.setBidirectional(true);
                     reverseEdge->setBidirectional(true);
                 } else {
-                    edge->setBidirectional(false);
+                    edge.setBidirectional(false);
                 }
             }
         } else {
 
-            std::vector<std::unique_ptr<Edge>> newEdges;
-            std::set<std::pair<Node*, Node*>> processedPairs;
+            std::vector<EdgeHandle> duplicates;
+            std::set<std::pair<NodeHandle, NodeHandle>> processedPairs;
 
-            for (auto& edge : m_edges) {
-                Node* first = edge->getFirst();
-                Node* second = edge->getSecond();
+            for (size_t i = 0; i < m_edges.size(); ++i) {
+                Edge& edge = m_edges[i];
+                NodeHandle first = edge.getFirst();
+                NodeHandle second = edge.getSecond();
 
 
                 auto orderedPair = std::make_pair(
@@ -156,204 +315,828 @@ public:
                     processedPairs.insert(orderedPair);
 
 
-                    edge->setOriented(false);
-                    edge->setBidirectional(false);
-                    newEdges.push_back(std::move(edge));
+                    edge.setOriented(false);
+                    edge.setBidirectional(false);
+                } else {
+                    duplicates.push_back(m_edges.handleAt(i));
                 }
             }
 
 
-            m_edges = std::move(newEdges);
+            for (EdgeHandle duplicate : duplicates) {
+                unlinkEdge(duplicate);
+                m_edges.remove(duplicate);
+            }
         }
 
 
-        updateEdges();
-        updateAdjacencyMatrix();
+        ++m_edgeVersion;
+        commitChanges();
     }
 
 
-    void draw() {
+    const NodeStore& getNodes() const {
+        return m_nodes;
+    }
 
-        for (const auto& edge : m_edges) {
-            edge->drawEdge(*m_window);
+    const SlotMap<Edge>& getEdges() const {
+        return m_edges;
+    }
+
+    // Bounding box of all node circles.
+    sf::FloatRect getBounds() const {
+        if (m_nodes.empty()) return sf::FloatRect();
+
+        float left = std::numeric_limits<float>::max(), top = left;
+        float right = std::numeric_limits<float>::lowest(), bottom = right;
+        for (size_t i = 0; i < m_nodes.size(); ++i) {
+            sf::Vector2f pos = m_nodes.getPosition(i);
+            float radius = m_nodes.getRadius(i);
+            left = std::min(left, pos.x - radius);
+            top = std::min(top, pos.y - radius);
+            right = std::max(right, pos.x + radius);
+            bottom = std::max(bottom, pos.y + radius);
+        }
+        return sf::FloatRect(left, top, right - left, bottom - top);
+    }
 
+    // Replaces the graph with the contents of a file in the format
+    // writeMatrixToFile produces. An asymmetric matrix loads as oriented.
+    // The file stores no positions, so nodes are laid out afterwards.
+    bool loadMatrixFile(const std::string& path) {
+        TRACE_ZONE("Graph::loadMatrixFile");
+        std::ifstream file(path);
+        size_t n = 0;
+        if (!file.is_open() || !(file >> n)) {
+            std::cerr << "Failed to read matrix file: " << path << std::endl;
+            return false;
+        }
 
-            if (edge->isBidirectional()) {
-                edge->drawReverseArrow(*m_window);
+        std::vector<uint32_t> ids(n);
+        for (uint32_t& id : ids) file >> id;
+        std::vector<std::pair<uint32_t, uint32_t>> entries;
+        for (uint32_t i = 0; i < n; ++i) {
+            for (uint32_t j = 0; j < n; ++j) {
+                int value = 0;
+                file >> value;
+                if (value) entries.emplace_back(i, j);
             }
         }
+        if (!file) {
+            std::cerr << "Malformed matrix file: " << path << std::endl;
+            return false;
+        }
 
+        // Rows are read in order, so entries are already sorted.
+        bool oriented = std::any_of(entries.begin(), entries.end(), [&](const std::pair<uint32_t, uint32_t>& e) {
+            return !std::binary_search(entries.begin(), entries.end(), std::make_pair(e.second, e.first));
+        });
+        return assignEdges(ids, entries, oriented);
+    }
 
-        for (const auto& node : m_nodes) {
-            node->drawNode(*m_window);
+    // Replaces the graph with nodes carrying the given ids and edges between
+    // their indices, all through the bulk path. Positions are used when
+    // there is one per node; otherwise the graph is laid out. Graphs with
+    // more nodes or edges than handles can address are refused. Handles
+    // from before stop resolving.
+    bool assignEdges(const std::vector<uint32_t>& ids, const std::vector<std::pair<uint32_t, uint32_t>>& edges,
+                     bool oriented, const std::vector<sf::Vector2f>& positions = {}) {
+        TRACE_ZONE("Graph::assignEdges");
+        const size_t n = ids.size();
+        if (n > NodeHandle::kMaxSlots || edges.size() > EdgeHandle::kMaxSlots) {
+            std::cerr << "Graph too large: " << n << " nodes and " << edges.size() << " edges, at most "
+                      << NodeHandle::kMaxSlots << " of each" << std::endl;
+            return false;
         }
+        Batch batch(*this);
+        stopLayoutRefinement();
+        m_dynamicNode = NodeHandle();
+        m_nodes.clear();
+        m_nodeIndex.clear();
+        m_nodeIndexBuilt = false;
+        m_incidentEdges.assign(n, {});
+        m_isOriented = oriented;
+        m_handlesById.clear();
+        m_handlesByIdBuilt = false;
+        m_streamedNodes = 0;
+
+        m_nextNodeId = 0;
+        m_nodes.reserve(n);
+        for (size_t i = 0; i < n; ++i) {
+            m_nodes.add(ids[i], sf::Vector2f());
+            m_nextNodeId = std::max(m_nextNodeId, ids[i]);
+        }
+        replaceEdges(edges);
 
+        if (positions.size() == n) {
+            applyLayout(positions);
+        } else if (m_layoutOnLoad) {
+            applyMultilevelLayout();
+        } else {
+            // A plain square grid, for runs that never look at positions.
+            size_t side = static_cast<size_t>(std::ceil(std::sqrt(static_cast<double>(n))));
+            for (size_t i = 0; i < n; ++i) {
+                m_nodes.setPosition(i, sf::Vector2f(60.f * (i % side), 60.f * (i / side)));
+            }
+        }
+        markDirty();
+        return true;
+    }
+
+    // Swaps the edge set for edges between node indices and keeps the nodes,
+    // so node handles stay valid.
+    void replaceEdges(const std::vector<std::pair<uint32_t, uint32_t>>& edges) {
+        TRACE_ZONE("Graph::replaceEdges");
+        const size_t n = m_nodes.size();
+        Batch batch(*this);
+        stopLayoutRefinement();
+        m_edges.clear();
+        for (auto& incident : m_incidentEdges) incident.clear();
+        m_edgeKeys.clear();
+        m_edgeKeysBuilt = false;
+        m_edgeIndex.clear();
+        m_edgeIndexBuilt = false;
+
+        std::vector<std::pair<NodeHandle, NodeHandle>> pairs;
+        pairs.reserve(edges.size());
+        for (const auto& edge : edges) {
+            if (edge.first < n && edge.second < n) pairs.emplace_back(m_nodes.handleAt(edge.first), m_nodes.handleAt(edge.second));
+        }
+        addEdges(pairs);
 
-        m_window->draw(m_orientationToggle);
-        m_window->draw(m_toggleText);
-        m_window->draw(m_helpText);
-        m_window->draw(m_modeText);
+        ++m_edgeVersion;
+        markDirty();
     }
 
-    void updateEdges() {
-        for (const auto& edge : m_edges) {
-            edge->updateLinePositions();
+    // Whether loaded graphs without positions get the multilevel layout.
+    void setLayoutOnLoad(bool layout) { m_layoutOnLoad = layout; }
+
+    // Reads the edge list format (EdgeList.hpp) in chunks; nodes get ids
+    // 1..n in file order.
+    bool loadEdgeListFile(const std::string& path) {
+        TRACE_ZONE("Graph::loadEdgeListFile");
+        EdgeListReader reader;
+        if (!reader.open(path)) return false;
+        std::vector<std::pair<uint32_t, uint32_t>> edges;
+        while (reader.read(edges, size_t(1) << 20)) {
+        }
+        if (reader.hasError()) {
+            std::cerr << "Malformed edge list: " << path << std::endl;
+            return false;
         }
+
+        std::vector<uint32_t> ids(reader.getNodeCount());
+        for (size_t i = 0; i < ids.size(); ++i) ids[i] = static_cast<uint32_t>(i + 1);
+        return assignEdges(ids, edges, reader.isOriented());
     }
 
-    const std::vector<std::unique_ptr<Node>>& getNodes() const {
-        return m_nodes;
+    bool saveEdgeListFile(const std::string& path) const {
+        EdgeListWriter writer;
+        if (!writer.open(path, m_nodes.size(), m_isOriented)) return false;
+        writer.write(edgeIndexPairs());
+        return writer.close();
     }
 
-private:
-    bool m_isOriented;
-    sf::RenderWindow* m_window;
-    sf::Font m_font;
-    std::vector<std::unique_ptr<Node>> m_nodes;
-    std::vector<std::unique_ptr<Edge>> m_edges;
-    std::vector<std::vector<int>> m_adjacencyMatrix;
-    uint8_t m_nextNodeId;
-    std::string m_matrixFilePath;
+    // Edge lists by their .edges extension, anything else as a matrix file.
+    static bool isEdgeListPath(const std::string& path) {
+        const std::string extension = ".edges";
+        return path.size() >= extension.size() &&
+               path.compare(path.size() - extension.size(), extension.size(), extension) == 0;
+    }
 
+    bool loadFile(const std::string& path) {
+        return isEdgeListPath(path) ? loadEdgeListFile(path) : loadMatrixFile(path);
+    }
 
-    sf::CircleShape m_orientationToggle;
-    sf::Text m_toggleText;
-    sf::Text m_helpText;
-    sf::Text m_modeText;
+    bool saveFile(const std::string& path) {
+        return isEdgeListPath(path) ? saveEdgeListFile(path) : saveMatrixFile(path);
+    }
+
+    // Writes the adjacency matrix in the format loadMatrixFile reads.
+    bool saveMatrixFile(const std::string& path) {
+        TRACE_ZONE("Graph::saveMatrixFile");
+        std::ofstream file(path);
+        if (!file.is_open()) {
+            std::cerr << "Failed to open file: " << path << std::endl;
+            return false;
+        }
+
+        file << m_nodes.size() << "\n";
+
+        for (size_t i = 0; i < m_nodes.size(); ++i) {
+            file << m_nodes.getId(i) << " ";
+        }
+        file << "\n";
+
+        // Row i is expanded from node i's incident list; every row has the
+        // same width, so single cells can later be patched in place.
+        const size_t n = m_nodes.size();
+        std::streamoff rowsStart = file.tellp();
+        std::streamoff rowStride = 0;
+        std::string row;
+        for (size_t i = 0; i < n; ++i) {
+            NodeHandle node = m_nodes.handleAt(i);
+            row.assign(2 * n, ' ');
+            for (size_t j = 0; j < n; ++j) row[2 * j] = '0';
+            for (EdgeHandle handle : m_incidentEdges[i]) {
+                const Edge* edge = m_edges.get(handle);
+                if (edge->getFirst() == node) row[2 * m_nodes.indexOf(edge->getSecond())] = '1';
+                else if (!m_isOriented) row[2 * m_nodes.indexOf(edge->getFirst())] = '1';
+            }
+            row += '\n';
+            file << row;
+            if (i == 0) rowStride = static_cast<std::streamoff>(file.tellp()) - rowsStart;
+        }
+        if (!file) return false;
 
-    void centerText(sf::Text& text, const sf::Vector2f& position) {
-        sf::FloatRect bounds = text.getLocalBounds();
-        text.setOrigin(bounds.left + bounds.width / 2.0f,
-                      bounds.top + bounds.height / 2.0f);
-        text.setPosition(position);
+        if (path == m_matrixFilePath) {
+            m_matrixRowsStart = rowsStart;
+            m_matrixRowStride = rowStride;
+        }
+        return true;
     }
 
-    void updateToggleAppearance() {
-        m_orientationToggle.setFillColor(
-            m_isOriented ? sf::Color(200, 200, 200) : sf::Color::White);
-        m_toggleText.setString(m_isOriented ? "D" : "U");
-        centerText(m_toggleText, m_orientationToggle.getPosition() +
-            sf::Vector2f(m_orientationToggle.getRadius(), m_orientationToggle.getRadius()));
+    sf::Vector2f getNodePosition(NodeHandle handle) const {
+        int64_t i = m_nodes.indexOf(handle);
+        return i < 0 ? sf::Vector2f() : m_nodes.getPosition(i);
     }
 
-    bool nodeExists(Node* node) const {
-        return std::any_of(m_nodes.begin(), m_nodes.end(),
-            [node](const auto& n) { return n.get() == node; });
+    void setNodeHighlighted(NodeHandle handle, bool highlighted) {
+        int64_t i = m_nodes.indexOf(handle);
+        if (i >= 0) {
+            m_nodes.setHighlighted(i, highlighted);
+        }
     }
 
-    bool edgeExists(Node* start, Node* end) const {
-        return std::any_of(m_edges.begin(), m_edges.end(),
-            [start, end, this](const auto& edge) {
-                if (m_isOriented) {
+    // Keeps current node and edge indices current by re-indexing the node
+    // and its edges.
+    void setNodePosition(NodeHandle handle, const sf::Vector2f& position) {
+        int64_t i = m_nodes.indexOf(handle);
+        if (i >= 0) {
+            bool nodeIndexed = isNodeIndexCurrent();
+            bool edgeIndexed = isEdgeIndexCurrent();
+            m_nodes.setPosition(i, position);
+            if (handle == m_dynamicNode) ++m_dynamicMoves;
+            if (nodeIndexed) {
+                indexNode(handle);
+                m_nodeIndexVersion = m_nodes.getPositionVersion();
+            }
+            if (edgeIndexed) {
+                for (EdgeHandle edge : m_incidentEdges[i]) indexEdge(edge);
+                m_edgeIndexVersion = m_nodes.getPositionVersion();
+            }
+        }
+    }
 
-                    return edge->getFirst() == start && edge->getSecond() == end;
-                } else {
+    // While a node is dragged the renderer caches everything else in a
+    // texture and redraws only this node and its incident edges.
+    void beginDrag(NodeHandle handle) {
+        setNodeHighlighted(handle, true);
+        m_dynamicNode = handle;
+    }
 
-                    return (edge->getFirst() == start && edge->getSecond() == end) ||
-                           (edge->getFirst() == end && edge->getSecond() == start);
-                }
-            });
+    void endDrag() {
+        NodeHandle handle = m_dynamicNode;
+        m_dynamicNode = NodeHandle();
+        setNodeHighlighted(handle, false);
     }
 
+    NodeHandle getDynamicNode() const { return m_dynamicNode; }
+
+    // Incident edge handles per dense node index.
+    const std::vector<std::vector<EdgeHandle>>& getIncidentLists() const { return m_incidentEdges; }
+
+    // Changes whenever nodes or edges change.
+    uint64_t getVersion() const { return m_nodes.getVersion() + m_edgeVersion; }
+
+    // Changes whenever edgeIndexPairs() might: edges change or nodes are removed.
+    uint64_t getEdgeVersion() const { return m_edgeVersion; }
+
+    // Like getVersion, but ignoring moves of the dragged node.
+    uint64_t getStaticVersion() const { return getVersion() - m_dynamicMoves; }
 
-    bool isPositionValid(const sf::Vector2f& newPos, float minDistance) const {
-        return std::all_of(m_nodes.begin(), m_nodes.end(),
-            [&newPos, minDistance](const auto& node) {
-                sf::Vector2f pos = node->getPosition();
-                float dx = newPos.x - pos.x;
-                float dy = newPos.y - pos.y;
-                return std::sqrt(dx * dx + dy * dy) >= minDistance;
-            });
+    const std::vector<EdgeHandle>& getIncidentEdges(NodeHandle handle) const {
+        static const std::vector<EdgeHandle> none;
+        int64_t i = m_nodes.indexOf(handle);
+        return i < 0 ? none : m_incidentEdges[i];
     }
 
-    Edge* findEdge(Node* start, Node* end) {
-        auto it = std::find_if(m_edges.begin(), m_edges.end(),
-            [start, end](const auto& edge) {
-                return edge->getFirst() == start && edge->getSecond() == end;
-            });
-        return it != m_edges.end() ? it->get() : nullptr;
+    // The first node (by dense index) whose circle contains point. Looked
+    // up through a grid of node boxes kept like the edge index below.
+    NodeHandle findNodeAt(const sf::Vector2f& point) {
+        syncNodeIndex();
+        int64_t found = -1;
+        m_nodeIndex.forEachNear(point, 0.f, [&](uint32_t value, const sf::Vector2f& a, const sf::Vector2f& b) {
+            sf::Vector2f delta = point - (a + b) / 2.f;
+            float radius = (b.x - a.x) / 2.f;
+            if (delta.x * delta.x + delta.y * delta.y > radius * radius) return;
+            NodeHandle handle;
+            handle.value = value;
+            int64_t i = m_nodes.indexOf(handle);
+            if (found < 0 || i < found) found = i;
+        });
+        return found < 0 ? NodeHandle() : m_nodes.handleAt(found);
     }
 
-    void cleanupDuplicateEdges() {
-        std::vector<std::unique_ptr<Edge>> newEdges;
-        std::set<std::pair<Node*, Node*>> processedPairs;
+    // The edge whose line passes nearest point, if any passes within
+    // tolerance. Lines run between node centres, so callers look for a node
+    // first. The segment index behind this is built on first use, follows
+    // edge edits and single node moves, and re-indexes every edge after a
+    // layout or other bulk move.
+    EdgeHandle findEdgeAt(const sf::Vector2f& point, float tolerance = 6.f) {
+        TRACE_ZONE("Graph::findEdgeAt");
+        syncEdgeIndex();
+        EdgeHandle handle;
+        handle.value = m_edgeIndex.nearest(point, tolerance);
+        return handle;
+    }
 
-        for (auto& edge : m_edges) {
-            Node* first = edge->getFirst();
-            Node* second = edge->getSecond();
+    // True when position keeps at least minDistance from every node other
+    // than ignore.
+    bool isPositionValid(const sf::Vector2f& newPos, float minDistance, NodeHandle ignore = NodeHandle()) const {
+        for (size_t i = 0; i < m_nodes.size(); ++i) {
+            if (m_nodes.handleAt(i) == ignore) continue;
+            sf::Vector2f pos = m_nodes.getPosition(i);
+            float dx = newPos.x - pos.x;
+            float dy = newPos.y - pos.y;
+            if (std::sqrt(dx * dx + dy * dy) < minDistance) return false;
+        }
+        return true;
+    }
 
+    bool isOriented() const { return m_isOriented; }
 
-            auto pair1 = std::make_pair(std::min(first, second), std::max(first, second));
+    // Each edge as a pair of indices into m_nodes.
+    std::vector<std::pair<uint32_t, uint32_t>> edgeIndexPairs() const {
+        std::vector<std::pair<uint32_t, uint32_t>> pairs;
+        pairs.reserve(m_edges.size());
+        for (const auto& edge : m_edges) {
+            pairs.emplace_back(static_cast<uint32_t>(m_nodes.indexOf(edge.getFirst())),
+                               static_cast<uint32_t>(m_nodes.indexOf(edge.getSecond())));
+        }
+        return pairs;
+    }
 
-            if (processedPairs.find(pair1) == processedPairs.end()) {
-                processedPairs.insert(pair1);
-                edge->setOriented(false);
-                newEdges.push_back(std::move(edge));
+    // Row u of the CSR holds the out-neighbours of m_nodes[u]; undirected
+    // edges (or all edges, when symmetric is set) are stored in both directions.
+    CsrGraph toCsr(bool symmetric = false) const {
+        std::vector<std::pair<uint32_t, uint32_t>> pairs = edgeIndexPairs();
+        if (!m_isOriented || symmetric) {
+            size_t count = pairs.size();
+            pairs.reserve(count * 2);
+            for (size_t i = 0; i < count; ++i) {
+                pairs.emplace_back(pairs[i].second, pairs[i].first);
             }
         }
+        return CsrGraph::fromEdges(m_nodes.size(), pairs);
+    }
+
+    // Scales node radii by PageRank; personalised around source when given.
+    PageRankResult applyPageRank(NodeHandle source = NodeHandle()) {
+        TRACE_ZONE("Graph::applyPageRank");
+        PageRankOptions options;
+        options.personalizeNode = getNodeIndex(source);
 
-        m_edges = std::move(newEdges);
+        PageRankResult result = computePageRank(toCsr(), options);
+        if (result.ranks.empty()) return result;
+
+        double maxRank = *std::max_element(result.ranks.begin(), result.ranks.end());
+        for (size_t i = 0; i < m_nodes.size(); ++i) {
+            double normalized = maxRank > 0.0 ? result.ranks[i] / maxRank : 0.0;
+            m_nodes.setRadius(i, 12.f + 16.f * static_cast<float>(std::sqrt(normalized)));
+        }
+        m_nodeIndex.clear();
+        m_nodeIndexBuilt = false;
+        return result;
     }
 
-    int getNodeIndex(Node* node) const {
+    // Colours nodes by betweenness; large graphs fall back to sampled pivots.
+    BetweennessResult applyBetweenness(size_t exactLimit = 2000, size_t sampleCount = 256) {
+        TRACE_ZONE("Graph::applyBetweenness");
+        BetweennessOptions options;
+        options.undirected = !m_isOriented;
+        if (m_nodes.size() > exactLimit) {
+            options.sampleCount = sampleCount;
+        }
+
+        BetweennessResult result = computeBetweenness(toCsr(), options);
+        applyHeatColors(result.scores);
+        return result;
+    }
+
+    // Runs Louvain on the undirected view, stores each node's community and
+    // colours nodes by it.
+    LouvainResult applyCommunities() {
+        TRACE_ZONE("Graph::applyCommunities");
+        LouvainResult result = Louvain().run(toCsr(true));
         for (size_t i = 0; i < m_nodes.size(); ++i) {
-            if (m_nodes[i].get() == node) return i;
+            m_nodes.setCommunity(i, result.community[i]);
+            m_nodes.setColor(i, communityColor(result.community[i]));
         }
-        return -1;
+        return result;
     }
 
-    void updateAdjacencyMatrix() {
-        size_t n = m_nodes.size();
-        m_adjacencyMatrix = std::vector<std::vector<int>>(n, std::vector<int>(n, 0));
+    // Area that applyLayout fits layouts into, usually the window size. With
+    // no area set, layouts keep their natural scale.
+    void setLayoutArea(const sf::Vector2f& size) {
+        m_layoutArea = size;
+    }
 
-        for (const auto& edge : m_edges) {
-            Node* start = edge->getFirst();
-            Node* end = edge->getSecond();
+    // Fits the given positions (indexed like getNodes()) into the layout
+    // area, never magnifying beyond the layout's own scale.
+    void applyLayout(const std::vector<sf::Vector2f>& positions) {
+        if (positions.size() != m_nodes.size() || positions.empty()) return;
+
+        sf::Vector2f min = positions.front();
+        sf::Vector2f max = positions.front();
+        for (const auto& p : positions) {
+            min.x = std::min(min.x, p.x);
+            min.y = std::min(min.y, p.y);
+            max.x = std::max(max.x, p.x);
+            max.y = std::max(max.y, p.y);
+        }
 
-            int startIdx = getNodeIndex(start);
-            int endIdx = getNodeIndex(end);
+        if (m_layoutArea.x <= 0.f || m_layoutArea.y <= 0.f) {
+            for (size_t i = 0; i < m_nodes.size(); ++i) {
+                m_nodes.setPosition(i, positions[i]);
+            }
+            return;
+        }
 
-            if (startIdx != -1 && endIdx != -1) {
-                if (m_isOriented) {
+        const float margin = 40.f;
+        sf::Vector2f area(m_layoutArea.x - 2 * margin, m_layoutArea.y - 2 * margin);
+        float scale = std::min({1.f,
+            area.x / std::max(max.x - min.x, 1.f),
+            area.y / std::max(max.y - min.y, 1.f)});
+        sf::Vector2f center = (min + max) / 2.f;
+        sf::Vector2f target = m_layoutArea / 2.f;
 
-                    m_adjacencyMatrix[startIdx][endIdx] = 1;
+        for (size_t i = 0; i < m_nodes.size(); ++i) {
+            m_nodes.setPosition(i, target + (positions[i] - center) * scale);
+        }
+    }
 
-                    if (edge->isBidirectional() || findEdge(end, start)) {
-                        m_adjacencyMatrix[endIdx][startIdx] = 1;
-                    }
-                } else {
+    void applyMultilevelLayout() {
+        TRACE_ZONE("Graph::applyMultilevelLayout");
+        applyLayout(MultilevelLayout().run(toCsr(true)));
+    }
 
-                    m_adjacencyMatrix[startIdx][endIdx] = 1;
-                    m_adjacencyMatrix[endIdx][startIdx] = 1;
-                }
-            }
+    // Moves nodes apart until no two circles come closer than gap. Works on
+    // the positions as shown, so it applies after any layout or bulk load;
+    // crowded layouts grow past the layout area rather than keep overlaps.
+    OverlapRemovalResult removeOverlaps(float gap = 4.f) {
+        TRACE_ZONE("Graph::removeOverlaps");
+        stopLayoutRefinement();
+        std::vector<sf::Vector2f> positions(m_nodes.size());
+        for (size_t i = 0; i < m_nodes.size(); ++i) positions[i] = m_nodes.getPosition(i);
+
+        OverlapRemovalOptions options;
+        options.gap = gap;
+        OverlapRemovalResult result = OverlapRemoval(options).run(positions, m_nodes.getRadii());
+        for (size_t i = 0; i < m_nodes.size(); ++i) m_nodes.setPosition(i, positions[i]);
+        return result;
+    }
+
+    // Distance-faithful layout: Pivot MDS right away, then sparse stress
+    // majorisation keeps refining it on a worker thread (see pollLayout).
+    void applyStressLayout(size_t pivotCount = 50) {
+        TRACE_ZONE("Graph::applyStressLayout");
+        const float edgeLength = 60.f;
+        CsrGraph csr = toCsr(true);
+        PivotDistances distances = PivotDistances::compute(csr, pivotCount);
+        std::vector<sf::Vector2f> positions = pivotMds(distances, m_nodes.size(), edgeLength);
+        applyLayout(positions);
+        m_stressRefiner.start(csr, std::move(distances), std::move(positions), edgeLength);
+    }
+
+    // Applies the newest positions streamed by a running layout refinement.
+    bool pollLayout() {
+        if (!m_stressRefiner.takePositions(m_streamedPositions)) return false;
+        applyLayout(m_streamedPositions);
+        return true;
+    }
+
+    void stopLayoutRefinement() {
+        m_stressRefiner.stop();
+    }
+
+    // Blocks until a running refinement finishes and applies its result.
+    void finishLayoutRefinement() {
+        m_stressRefiner.wait();
+        pollLayout();
+    }
+
+    // True while a refinement may still stream new positions.
+    bool isLayoutRunning() {
+        return m_stressRefiner.isRunning() || m_stressRefiner.hasPositions();
+    }
+
+    // The model's share of a memory report. Incidence is the per-node edge
+    // handle lists; layout is the positions streamed from the refiner.
+    void reportMemory(MemoryReport& report) const {
+        report.add("nodes", m_nodes.memoryUsage());
+        report.add("edges", {m_edges.memoryBytes(), m_edges.size()});
+
+        MemoryUsage incidence{heapBytes(m_incidentEdges), 0};
+        for (const auto& list : m_incidentEdges) {
+            incidence.bytes += heapBytes(list);
+            incidence.objects += list.size();
         }
-        writeMatrixToFile();
+        report.add("incidence", incidence);
+        report.add("layout", {heapBytes(m_streamedPositions), m_streamedPositions.size()});
+        if (m_handlesByIdBuilt || m_edgeKeysBuilt) {
+            report.add("stream index", {m_handlesById.memoryBytes() + m_edgeKeys.memoryBytes(),
+                                        m_handlesById.size() + m_edgeKeys.size()});
+        }
+        if (m_nodeIndexBuilt) report.add("node index", {m_nodeIndex.memoryBytes(), m_nodeIndex.size()});
+        if (m_edgeIndexBuilt) report.add("edge index", {m_edgeIndex.memoryBytes(), m_edgeIndex.size()});
     }
 
+    // Triangles and clustering on the undirected view; colours nodes by
+    // their local clustering coefficient.
+    TriangleResult applyClustering(const TriangleOptions& options = {}) {
+        TRACE_ZONE("Graph::applyClustering");
+        CsrGraph csr = toCsr(true);
+        csr.sortRows();
+        TriangleResult result = computeTriangles(csr, options);
+        applyHeatColors(result.clustering);
+        return result;
+    }
 
-    void writeMatrixToFile() {
-        std::ofstream file(m_matrixFilePath);
-        if (!file.is_open()) {
-            std::cerr << "Failed to open file: " << m_matrixFilePath << std::endl;
-            return;
+    std::vector<double> applyCloseness() {
+        TRACE_ZONE("Graph::applyCloseness");
+        std::vector<double> closeness = computeCloseness(toCsr());
+        applyHeatColors(closeness);
+        return closeness;
+    }
+
+private:
+    bool m_isOriented;
+    NodeStore m_nodes;
+    SlotMap<Edge> m_edges;
+    // Set while the matrix file lags behind the graph.
+    bool m_matrixFileDirty = false;
+    // Where the rows of the matrix file start and how far apart they are.
+    std::streamoff m_matrixRowsStart = 0;
+    std::streamoff m_matrixRowStride = 0;
+    int m_batchDepth = 0;
+    uint32_t m_nextNodeId;
+    std::string m_matrixFilePath;
+    StressRefiner m_stressRefiner;
+    sf::Vector2f m_layoutArea;
+    bool m_layoutOnLoad = true;
+    uint64_t m_edgeVersion = 0;
+    // Edge handles touching each node, indexed like m_nodes.
+    std::vector<std::vector<EdgeHandle>> m_incidentEdges;
+    NodeHandle m_dynamicNode;
+    // Node-store version bumps caused by moving the dragged node; they are
+    // subtracted out so those moves do not invalidate the static layer.
+    uint64_t m_dynamicMoves = 0;
+    std::vector<sf::Vector2f> m_streamedPositions;
+    // Node ids to handle values for edge streams; built on the first batch.
+    KeyIndex m_handlesById;
+    bool m_handlesByIdBuilt = false;
+    // Directed (first, second) node handle pairs to edge handle values, for
+    // streams that look up an edge per event; kept current by linkEdge and
+    // unlinkEdge once built.
+    KeyIndex m_edgeKeys;
+    bool m_edgeKeysBuilt = false;
+    // Edge lines by edge slot, for findEdgeAt. Edges enter and leave it in
+    // linkEdge and unlinkEdge once built; positions are current while
+    // m_edgeIndexVersion equals the node store's position version.
+    SegmentIndex m_edgeIndex;
+    bool m_edgeIndexBuilt = false;
+    uint64_t m_edgeIndexVersion = 0;
+    // Node boxes by node slot, for findNodeAt, kept the same way; nodes
+    // enter and leave it where they are added and removed.
+    SegmentIndex m_nodeIndex;
+    bool m_nodeIndexBuilt = false;
+    uint64_t m_nodeIndexVersion = 0;
+    size_t m_streamedNodes = 0;
+
+    void applyHeatColors(const std::vector<double>& scores) {
+        if (scores.size() != m_nodes.size() || scores.empty()) return;
+
+        auto [minIt, maxIt] = std::minmax_element(scores.begin(), scores.end());
+        double range = *maxIt - *minIt;
+        for (size_t i = 0; i < m_nodes.size(); ++i) {
+            float t = range > 0.0 ? static_cast<float>((scores[i] - *minIt) / range) : 0.f;
+            m_nodes.setColor(i, sf::Color(
+                static_cast<sf::Uint8>(52 + t * (235 - 52)),
+                static_cast<sf::Uint8>(235 - t * (235 - 64)),
+                static_cast<sf::Uint8>(168 - t * (168 - 52))));
         }
+    }
 
+    static sf::Color communityColor(uint32_t community) {
+        // Golden-angle hue steps keep neighbouring ids visually apart.
+        float hue = std::fmod(community * 137.508f, 360.f) / 60.f;
+        float x = 1.f - std::abs(std::fmod(hue, 2.f) - 1.f);
+        float r = 0.f, g = 0.f, b = 0.f;
+        switch (static_cast<int>(hue)) {
+            case 0: r = 1.f; g = x; break;
+            case 1: r = x; g = 1.f; break;
+            case 2: g = 1.f; b = x; break;
+            case 3: g = x; b = 1.f; break;
+            case 4: r = x; b = 1.f; break;
+            default: r = 1.f; b = x; break;
+        }
+        auto channel = [](float v) { return static_cast<sf::Uint8>(90 + v * 150); };
+        return sf::Color(channel(r), channel(g), channel(b));
+    }
 
-        file << m_nodes.size() << "\n";
+    bool nodeExists(NodeHandle node) const {
+        return m_nodes.contains(node);
+    }
 
+    static uint64_t edgeKey(NodeHandle start, NodeHandle end) {
+        return (static_cast<uint64_t>(start.value) << 32) | end.value;
+    }
 
-        for (const auto& node : m_nodes) {
-            file << int(node->getId()) << " ";
+    void linkEdge(EdgeHandle handle) {
+        const Edge* edge = std::as_const(m_edges).get(handle);
+        if (m_edgeKeysBuilt) m_edgeKeys.insert(edgeKey(edge->getFirst(), edge->getSecond()), handle.value);
+        if (m_edgeIndexBuilt) indexEdge(handle);
+        m_incidentEdges[m_nodes.indexOf(edge->getFirst())].push_back(handle);
+        if (edge->getSecond() != edge->getFirst()) {
+            m_incidentEdges[m_nodes.indexOf(edge->getSecond())].push_back(handle);
         }
-        file << "\n";
+    }
 
+    void unlinkEdge(EdgeHandle handle) {
+        const Edge* edge = std::as_const(m_edges).get(handle);
+        if (m_edgeKeysBuilt) m_edgeKeys.erase(edgeKey(edge->getFirst(), edge->getSecond()));
+        if (m_edgeIndexBuilt) m_edgeIndex.remove(handle.index());
+        eraseIncident(edge->getFirst(), handle);
+        if (edge->getSecond() != edge->getFirst()) eraseIncident(edge->getSecond(), handle);
+    }
 
-        for (const auto& row : m_adjacencyMatrix) {
-            for (int val : row) {
-                file << val << " ";
-            }
-            file << "\n";
+    bool isEdgeIndexCurrent() const {
+        return m_edgeIndexBuilt && m_edgeIndexVersion == m_nodes.getPositionVersion();
+    }
+
+    void indexEdge(EdgeHandle handle) {
+        const Edge* edge = std::as_const(m_edges).get(handle);
+        m_edgeIndex.insert(handle.index(), handle.value, getNodePosition(edge->getFirst()),
+                           getNodePosition(edge->getSecond()));
+    }
+
+    // Builds the edge index, or moves every edge to its current place when
+    // nodes moved behind its back; the cells stay allocated for that.
+    void syncEdgeIndex() {
+        if (isEdgeIndexCurrent()) return;
+        TRACE_ZONE("Graph::syncEdgeIndex");
+        if (!m_edgeIndexBuilt) m_edgeIndex.reserve(m_edges.size());
+        for (size_t i = 0; i < m_edges.size(); ++i) indexEdge(m_edges.handleAt(i));
+        m_edgeIndexBuilt = true;
+        m_edgeIndexVersion = m_nodes.getPositionVersion();
+    }
+
+    bool isNodeIndexCurrent() const {
+        return m_nodeIndexBuilt && m_nodeIndexVersion == m_nodes.getPositionVersion();
+    }
+
+    void indexNode(NodeHandle handle) {
+        int64_t i = m_nodes.indexOf(handle);
+        sf::Vector2f center = m_nodes.getPosition(i);
+        sf::Vector2f extent(m_nodes.getRadius(i), m_nodes.getRadius(i));
+        m_nodeIndex.insert(handle.index(), handle.value, center - extent, center + extent);
+    }
+
+    void syncNodeIndex() {
+        if (isNodeIndexCurrent()) return;
+        TRACE_ZONE("Graph::syncNodeIndex");
+        if (!m_nodeIndexBuilt) m_nodeIndex.reserve(m_nodes.size());
+        for (size_t i = 0; i < m_nodes.size(); ++i) indexNode(m_nodes.handleAt(i));
+        m_nodeIndexBuilt = true;
+        m_nodeIndexVersion = m_nodes.getPositionVersion();
+    }
+
+    void eraseIncident(NodeHandle node, EdgeHandle handle) {
+        auto& incident = m_incidentEdges[m_nodes.indexOf(node)];
+        auto it = std::find(incident.begin(), incident.end(), handle);
+        if (it != incident.end()) {
+            *it = incident.back();
+            incident.pop_back();
+        }
+    }
+
+    // O(1) once a stream built the edge key index, else O(min degree): the
+    // edge is on both endpoints' incident lists, so the shorter one is searched.
+    EdgeHandle findEdgeHandle(NodeHandle start, NodeHandle end) const {
+        if (m_edgeKeysBuilt) {
+            EdgeHandle handle;
+            handle.value = m_edgeKeys.find(edgeKey(start, end));
+            return handle;
+        }
+        int64_t i = m_nodes.indexOf(start);
+        int64_t j = m_nodes.indexOf(end);
+        if (i < 0 || j < 0) return EdgeHandle();
+        if (m_incidentEdges[j].size() < m_incidentEdges[i].size()) i = j;
+        for (EdgeHandle handle : m_incidentEdges[i]) {
+            const Edge* edge = m_edges.get(handle);
+            if (edge->getFirst() == start && edge->getSecond() == end) return handle;
         }
+        return EdgeHandle();
+    }
+
+    Edge* findEdge(NodeHandle start, NodeHandle end) {
+        return m_edges.get(findEdgeHandle(start, end));
+    }
+
+    // Drops an edge in O(degree); the reverse of an oriented edge stops
+    // being drawn as bidirectional.
+    void eraseEdge(EdgeHandle handle) {
+        const Edge* edge = std::as_const(m_edges).get(handle);
+        if (m_isOriented) {
+            if (Edge* reverse = findEdge(edge->getSecond(), edge->getFirst())) reverse->setBidirectional(false);
+        }
+        unlinkEdge(handle);
+        m_edges.remove(handle);
+        ++m_edgeVersion;
+    }
+
+    void indexNodeId(NodeHandle handle) {
+        if (m_handlesByIdBuilt) m_handlesById.insert(m_nodes.getId(m_nodes.indexOf(handle)), handle.value);
+    }
+
+    NodeHandle findNodeById(uint32_t id) const {
+        NodeHandle handle;
+        handle.value = m_handlesById.find(id);
+        return m_nodes.contains(handle) ? handle : NodeHandle();
+    }
+
+    // The node with this id, created if the stream has not mentioned it
+    // yet: near anchor when given, else on a sunflower spiral around the
+    // middle of the layout area, which fills outwards at even density.
+    NodeHandle streamNode(uint32_t id, NodeHandle anchor) {
+        NodeHandle handle = findNodeById(id);
+        if (handle) return handle;
+
+        const float goldenAngle = 2.39996323f;
+        sf::Vector2f position;
+        if (anchor) {
+            float angle = id * goldenAngle;
+            position = getNodePosition(anchor) + 60.f * sf::Vector2f(std::cos(angle), std::sin(angle));
+        } else {
+            float angle = m_streamedNodes * goldenAngle;
+            float radius = 40.f * std::sqrt(static_cast<float>(m_streamedNodes));
+            position = m_layoutArea / 2.f + radius * sf::Vector2f(std::cos(angle), std::sin(angle));
+        }
+        ++m_streamedNodes;
+        handle = m_nodes.add(id, position);
+        if (m_nodeIndexBuilt) indexNode(handle);
+        m_incidentEdges.emplace_back();
+        m_handlesById.insert(id, handle.value);
+        m_nextNodeId = std::max(m_nextNodeId, id);
+        markDirty();
+        return handle;
+    }
+
+    int getNodeIndex(NodeHandle node) const {
+        return static_cast<int>(m_nodes.indexOf(node));
+    }
+
+    void markDirty() {
+        m_matrixFileDirty = true;
+    }
+
+    // Rewrites the matrix file now, or when the enclosing Batch closes.
+    void commitChanges() {
+        markDirty();
+        if (m_batchDepth == 0) writeMatrixToFile();
+    }
+
+    // An edge edit flips the cell (start, end), and its mirror when the
+    // graph is undirected. While the file is otherwise current those cells
+    // are overwritten in place instead of rewriting all n^2 of them.
+    void commitEdgeChange(NodeHandle start, NodeHandle end, bool present) {
+        if (m_batchDepth == 0 && !m_matrixFileDirty && patchMatrixFile(start, end, present)) return;
+        commitChanges();
+    }
+
+    bool patchMatrixFile(NodeHandle start, NodeHandle end, bool present) {
+        if (m_matrixFilePath.empty()) return true;
+        if (m_matrixRowStride == 0) return false;
+        std::fstream file(m_matrixFilePath, std::ios::in | std::ios::out | std::ios::binary);
+        if (!file.is_open()) return false;
+
+        int64_t u = m_nodes.indexOf(start);
+        int64_t v = m_nodes.indexOf(end);
+        auto setCell = [&](int64_t row, int64_t column) {
+            file.seekp(m_matrixRowsStart + row * m_matrixRowStride + 2 * column);
+            file.put(present ? '1' : '0');
+        };
+        setCell(u, v);
+        if (!m_isOriented) setCell(v, u);
+        return static_cast<bool>(file);
+    }
+
+    void writeMatrixToFile() {
+        TRACE_ZONE("Graph::writeMatrixToFile");
+        m_matrixFileDirty = false;
+        m_matrixRowStride = 0;
+        if (m_matrixFilePath.empty()) return;
+        saveMatrixFile(m_matrixFilePath);
     }
-};
\ No newline at end of file
+};
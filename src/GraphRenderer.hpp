@@ -0,0 +1,171 @@
+#pragma once
+#include "RenderWorker.hpp"
+#include <SFML/Graphics.hpp>
+#include <string>
+
+// Everything the renderer reads from the graph for one frame.
+struct RenderScene {
+    const NodeStore& nodes;
+    const SlotMap<Edge>& edges;
+    const sf::Font& font;
+    // Changes whenever anything drawn changes.
+    uint64_t version;
+    // Changes whenever anything other than the dynamic node and its incident
+    // edges changes; equal to version when there is no dynamic node.
+    uint64_t staticVersion;
+    // The node being dragged, if any.
+    NodeHandle dynamicNode;
+    // Incident edge handles per dense node index.
+    const std::vector<std::vector<EdgeHandle>>* incidentEdges;
+    // False when edges are drawn by someone else (edge bundling).
+    bool drawEdges;
+};
+
+// Draws the batches the render worker builds. While a node is dragged,
+// everything else is rendered once into an off-screen texture and blitted as
+// a single sprite; only the dragged node and its incident edges are built on
+// this thread each frame. A rebuild shows up a frame or so after the change
+// that caused it, unless the caller asks to wait.
+class GraphRenderer {
+public:
+    static constexpr unsigned kLabelSize = BatchBuilder::kLabelSize;
+
+    static sf::Color edgeColor() { return BatchBuilder::edgeColor(); }
+
+    void draw(sf::RenderTarget& target, const RenderScene& scene, bool waitForWorker = false) {
+        TRACE_ZONE("GraphRenderer::draw");
+        if (!m_atlasReady) createAtlas();
+        m_builder.setFont(scene.font);
+
+        uint64_t version = scene.dynamicNode ? scene.staticVersion : scene.version;
+        if (version != m_requestedVersion || scene.dynamicNode != m_requestedExcludes ||
+            scene.drawEdges != m_requestedDrawEdges) {
+            m_worker.submit(m_builder, scene.nodes, scene.edges, scene.drawEdges, version, scene.dynamicNode);
+            m_requestedVersion = version;
+            m_requestedExcludes = scene.dynamicNode;
+            m_requestedDrawEdges = scene.drawEdges;
+        }
+
+        bool swapped = waitForWorker || !m_worker.hasFront() ? m_worker.finish() : m_worker.swapBuffers();
+        const RenderBatch& front = m_worker.front();
+
+        // The front batch may leave out a node that is no longer (or not yet)
+        // the dragged one; draw it on top until the matching batch arrives.
+        NodeHandle missing = m_worker.frontExcludes();
+        if (!missing || missing != scene.dynamicNode) {
+            drawBatch(target, front, scene.font);
+            if (missing) {
+                buildDynamic(scene, missing);
+                drawBatch(target, m_dynamic, scene.font);
+            }
+            return;
+        }
+
+        sf::Vector2u size = target.getSize();
+        bool resized = m_layer.getSize() != size;
+        if (swapped || resized || !m_layerValid) renderLayer(target, front, scene.font, resized);
+
+        if (!m_layerValid) {
+            drawBatch(target, front, scene.font);
+        } else {
+            sf::View view = target.getView();
+            target.setView(target.getDefaultView());
+            target.draw(sf::Sprite(m_layer.getTexture()));
+            target.setView(view);
+        }
+
+        buildDynamic(scene, missing);
+        drawBatch(target, m_dynamic, scene.font);
+    }
+
+    // True while the worker still owes a batch for the last submitted scene.
+    bool isBusy() { return m_worker.isBusy(); }
+
+    // True when the next draw would show newer geometry than the last one.
+    bool hasNewFrame() { return m_worker.hasBackReady(); }
+
+    // Batches (vertices in use, not capacity) and textures; objects are
+    // vertices.
+    MemoryUsage memoryUsage() {
+        MemoryUsage usage = m_worker.memoryUsage();
+        usage += m_dynamic.memoryUsage();
+        if (m_atlasReady) usage.bytes += textureBytes(m_atlas);
+        if (m_layerValid) usage.bytes += textureBytes(m_layer.getTexture());
+        return usage;
+    }
+
+private:
+    static constexpr unsigned kAtlasCell = BatchBuilder::kAtlasCell;
+    sf::Texture m_atlas;
+    bool m_atlasReady = false;
+
+    BatchBuilder m_builder;
+    RenderWorker m_worker;
+    uint64_t m_requestedVersion = UINT64_MAX;
+    NodeHandle m_requestedExcludes;
+    bool m_requestedDrawEdges = true;
+
+    RenderBatch m_dynamic;
+
+    sf::RenderTexture m_layer;
+    bool m_layerValid = false;
+
+    void drawBatch(sf::RenderTarget& target, const RenderBatch& batch, const sf::Font& font) const {
+        target.draw(batch.lines);
+        target.draw(batch.arrows);
+        target.draw(batch.circles, sf::RenderStates(&m_atlas));
+        target.draw(batch.labels, sf::RenderStates(&font.getTexture(kLabelSize)));
+    }
+
+    void renderLayer(const sf::RenderTarget& target, const RenderBatch& batch, const sf::Font& font, bool resized) {
+        TRACE_ZONE("GraphRenderer::renderLayer");
+        if (resized || !m_layerValid) {
+            m_layerValid = m_layer.create(target.getSize().x, target.getSize().y);
+        }
+        m_layer.setView(target.getView());
+        m_layer.clear(sf::Color::Transparent);
+        drawBatch(m_layer, batch, font);
+        m_layer.display();
+    }
+
+    // O(degree): one node and its incident edges.
+    void buildDynamic(const RenderScene& scene, NodeHandle node) {
+        m_dynamic.clear();
+        int64_t index = scene.nodes.indexOf(node);
+        if (index < 0) return;
+
+        if (scene.drawEdges) {
+            for (EdgeHandle handle : (*scene.incidentEdges)[index]) {
+                if (const Edge* edge = scene.edges.get(handle)) BatchBuilder::appendEdge(m_dynamic, scene.nodes, *edge);
+            }
+        }
+        m_builder.appendNode(m_dynamic, scene.nodes, index);
+    }
+
+    // Two white discs with black rims, the second with the thicker
+    // highlight rim. Vertex colours multiply white to the node colour and
+    // leave black untouched.
+    void createAtlas() {
+        sf::Image image;
+        image.create(kAtlasCell * 2, kAtlasCell, sf::Color::Transparent);
+        const float outer = kAtlasCell / 2.f - 1.f;
+        for (unsigned cell = 0; cell < 2; ++cell) {
+            float inner = outer / (1.f + (cell ? BatchBuilder::kHighlightOutline : BatchBuilder::kOutline));
+            for (unsigned y = 0; y < kAtlasCell; ++y) {
+                for (unsigned x = 0; x < kAtlasCell; ++x) {
+                    float dx = x + 0.5f - kAtlasCell / 2.f;
+                    float dy = y + 0.5f - kAtlasCell / 2.f;
+                    float d = std::sqrt(dx * dx + dy * dy);
+                    float coverage = std::max(0.f, std::min(1.f, outer - d + 0.5f));
+                    float fill = std::max(0.f, std::min(1.f, inner - d + 0.5f));
+                    auto shade = static_cast<sf::Uint8>(255 * fill);
+                    image.setPixel(cell * kAtlasCell + x, y,
+                                   sf::Color(shade, shade, shade, static_cast<sf::Uint8>(255 * coverage)));
+                }
+            }
+        }
+        m_atlas.loadFromImage(image);
+        m_atlas.setSmooth(true);
+        m_atlasReady = true;
+    }
+};
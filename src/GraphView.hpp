@@ -0,0 +1,337 @@
+#pragma once
+#include "Graph.hpp"
+#include "EdgeBundler.hpp"
+#include "GraphRenderer.hpp"
+#include "Timeline.hpp"
+#include <SFML/Graphics.hpp>
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+
+// Puts a Graph on screen: the renderer, edge bundling and the on-screen
+// widgets. Without a window it can still draw the graph into any render
+// target, which is how image export uses it. The font is borrowed, not
+// copied, and must outlive the view.
+class GraphView {
+public:
+    GraphView(Graph& graph, sf::RenderWindow& window, const sf::Font& font)
+        : m_graph(graph), m_window(&window), m_font(font) {
+        m_graph.setLayoutArea(sf::Vector2f(static_cast<float>(window.getSize().x),
+                                           static_cast<float>(window.getSize().y)));
+        initializeUI();
+    }
+
+    GraphView(Graph& graph, const sf::Font& font)
+        : m_graph(graph), m_window(nullptr), m_font(font) {
+        initializeUI();
+    }
+
+    const Graph& getGraph() const { return m_graph; }
+
+    void initializeUI() {
+
+        m_orientationToggle.setRadius(kToggleRadius);
+        m_orientationToggle.setPosition(kTogglePosition);
+        m_orientationToggle.setFillColor(sf::Color::White);
+        m_orientationToggle.setOutlineColor(sf::Color::Black);
+        m_orientationToggle.setOutlineThickness(2.f);
+
+
+        m_toggleText.setFont(m_font);
+        m_toggleText.setString("U");
+        m_toggleText.setCharacterSize(20);
+        m_toggleText.setFillColor(sf::Color::Black);
+        centerText(m_toggleText, m_orientationToggle.getPosition() +
+            sf::Vector2f(m_orientationToggle.getRadius(), m_orientationToggle.getRadius()));
+
+
+        m_helpText.setFont(m_font);
+        m_helpText.setString("Click to toggle orientation (U/D)");
+        m_helpText.setCharacterSize(17);
+        m_helpText.setFillColor(sf::Color::Black);
+        m_helpText.setPosition( 45.f, 14.f);
+
+
+        m_modeText.setFont(m_font);
+        m_modeText.setCharacterSize(17);
+        m_modeText.setFillColor(sf::Color::Black);
+        m_modeText.setPosition(10.f, 570.f);
+        updateModeText(false);
+        updateToggleAppearance();
+
+
+        m_memoryText.setFont(m_font);
+        m_memoryText.setCharacterSize(14);
+        m_memoryText.setFillColor(sf::Color::Black);
+        m_memoryText.setPosition(10.f, 45.f);
+
+
+        m_timelineTrack.setFillColor(sf::Color(210, 210, 210));
+        m_timelineFill.setFillColor(sf::Color(70, 130, 220));
+        m_timelineKnob.setRadius(kKnobRadius);
+        m_timelineKnob.setOrigin(kKnobRadius, kKnobRadius);
+        m_timelineKnob.setFillColor(sf::Color::White);
+        m_timelineKnob.setOutlineColor(sf::Color(70, 130, 220));
+        m_timelineKnob.setOutlineThickness(2.f);
+        m_timelineText.setFont(m_font);
+        m_timelineText.setCharacterSize(14);
+        m_timelineText.setFillColor(sf::Color::Black);
+    }
+
+    // Shows a timeline slider for the playback; null hides it.
+    void setPlayback(const TemporalPlayback* playback) {
+        m_playback = playback;
+        ++m_uiVersion;
+    }
+
+    // The slider's track in a window of the given size. Like the toggle it
+    // needs no view, so headless replays hit it the same way.
+    static sf::FloatRect timelineTrack(const sf::Vector2f& area) {
+        return sf::FloatRect(260.f, area.y - 34.f, std::max(area.x - 300.f, 40.f), 8.f);
+    }
+
+    // The toggle sits at a fixed place, so this needs no view (replays
+    // without a window hit it exactly like the interactive loop does).
+    static bool hitsOrientationToggle(const sf::Vector2f& mousePos) {
+        sf::Vector2f toggleCenter = kTogglePosition + sf::Vector2f(kToggleRadius, kToggleRadius);
+
+        float distance = std::sqrt(
+            std::pow(mousePos.x - toggleCenter.x, 2) +
+            std::pow(mousePos.y - toggleCenter.y, 2)
+        );
+        return distance <= kToggleRadius;
+    }
+
+    bool handleToggleClick(const sf::Vector2f& mousePos) {
+        if (hitsOrientationToggle(mousePos)) {
+            m_graph.toggleOrientation();
+            updateToggleAppearance();
+            return true;
+        }
+        return false;
+    }
+
+    void updateModeText(bool isDrawingMode) {
+        m_modeText.setString(isDrawingMode ? "Drawing Mode (press D to change)" : "Movement Mode (press D to change)");
+        ++m_uiVersion;
+    }
+
+    void toggleBundling() {
+        m_isBundled = !m_isBundled;
+        m_bundler.invalidate();
+        m_bundleStale = true;
+        ++m_uiVersion;
+    }
+
+    // Edges drawn wider on top of the graph: the one under the pointer and
+    // the selected one. Handles of deleted edges are simply not drawn.
+    void setHoveredEdge(EdgeHandle edge) {
+        if (edge == m_hoveredEdge) return;
+        m_hoveredEdge = edge;
+        ++m_uiVersion;
+    }
+
+    void setSelectedEdge(EdgeHandle edge) {
+        if (edge == m_selectedEdge) return;
+        m_selectedEdge = edge;
+        ++m_uiVersion;
+    }
+
+    void toggleMemoryOverlay() {
+        m_showMemory = !m_showMemory;
+        ++m_uiVersion;
+    }
+
+    // Everything the view and its graph hold.
+    void reportMemory(MemoryReport& report) {
+        m_graph.reportMemory(report);
+        report.add("render", m_renderer.memoryUsage());
+        report.add("bundling", m_bundler.memoryUsage());
+        // Glyph pages for the sizes drawn here; the face itself is shared.
+        report.add("fonts", {textureBytes(m_font.getTexture(GraphRenderer::kLabelSize)) +
+                                 textureBytes(m_font.getTexture(17)) + textureBytes(m_font.getTexture(14)),
+                             1});
+    }
+
+    // Replays pass true so each frame shows the effect of the event before it.
+    void draw(bool waitForGeometry = false) {
+        TRACE_ZONE("GraphView::draw");
+        if (m_shownOrientation != m_graph.isOriented()) updateToggleAppearance();
+        drawGraph(*m_window, waitForGeometry);
+        drawEdgeHighlights();
+
+        m_window->draw(m_orientationToggle);
+        m_window->draw(m_toggleText);
+        m_window->draw(m_helpText);
+        m_window->draw(m_modeText);
+
+        if (m_playback) drawTimeline();
+
+        if (m_showMemory) {
+            MemoryReport report;
+            reportMemory(report);
+            m_memoryText.setString(report.toText());
+            m_window->draw(m_memoryText);
+        }
+    }
+
+    // Nodes and edges only, in the target's current view. The interactive
+    // loop passes false so geometry rebuilds never stall a frame; one-off
+    // renders wait for the current geometry.
+    void drawGraph(sf::RenderTarget& target, bool waitForGeometry = true) {
+        const NodeStore& nodes = m_graph.getNodes();
+        if (m_isBundled) {
+            syncBundler();
+            target.draw(m_bundler.getVertices());
+        }
+
+        RenderScene scene{nodes, m_graph.getEdges(), m_font, m_graph.getVersion(), m_graph.getStaticVersion(),
+                          m_graph.getDynamicNode(), &m_graph.getIncidentLists(), !m_isBundled};
+        m_renderer.draw(target, scene, waitForGeometry);
+    }
+
+    // Changes whenever anything draw() shows changes: nodes, edges,
+    // highlights and the widgets.
+    uint64_t getFrameVersion() const {
+        return m_graph.getVersion() + m_uiVersion + (m_shownOrientation != m_graph.isOriented()) +
+               (m_playback ? m_playback->getVersion() : 0);
+    }
+
+    // True while something will change the picture without further input:
+    // a layout still streaming positions, geometry still being built, or a
+    // timeline playing or easing.
+    bool isAnimating() {
+        return m_graph.isLayoutRunning() || m_renderer.isBusy() || (m_playback && m_playback->isAnimating());
+    }
+
+    // True when geometry built in the background is ready to be shown.
+    bool hasNewFrame() {
+        return m_renderer.hasNewFrame();
+    }
+
+private:
+    // The bundler's inputs are copied out of the graph only when the graph
+    // changed since the last frame, so a still picture costs nothing here.
+    void syncBundler() {
+        const NodeStore& nodes = m_graph.getNodes();
+        bool changed = m_bundleStale || m_bundleOriented != m_graph.isOriented();
+        if (changed || m_bundleEdgeVersion != m_graph.getEdgeVersion()) {
+            m_bundleEdges = m_graph.edgeIndexPairs();
+            m_bundleEdgeVersion = m_graph.getEdgeVersion();
+            changed = true;
+        }
+        // Removals bump the edge version, so together with the size this
+        // catches every change to the node order.
+        if (changed || m_bundlePositionVersion != nodes.getPositionVersion() ||
+            m_bundlePositions.size() != nodes.size()) {
+            m_bundlePositions.resize(nodes.size());
+            for (size_t i = 0; i < nodes.size(); ++i) {
+                m_bundlePositions[i] = nodes.getPosition(i);
+            }
+            m_bundlePositionVersion = nodes.getPositionVersion();
+            changed = true;
+        }
+        if (!changed) return;
+        m_bundleOriented = m_graph.isOriented();
+        m_bundleStale = false;
+        m_bundler.update(m_bundlePositions, m_bundleEdges, m_bundleOriented);
+    }
+
+    static constexpr float kToggleRadius = 15.f;
+    static inline const sf::Vector2f kTogglePosition{10.f, 10.f};
+    static constexpr float kKnobRadius = 8.f;
+
+    Graph& m_graph;
+    sf::RenderWindow* m_window;
+    const sf::Font& m_font;
+    EdgeBundler m_bundler;
+    bool m_isBundled = false;
+    std::vector<sf::Vector2f> m_bundlePositions;
+    std::vector<std::pair<uint32_t, uint32_t>> m_bundleEdges;
+    uint64_t m_bundleEdgeVersion = 0;
+    uint64_t m_bundlePositionVersion = 0;
+    bool m_bundleOriented = false;
+    bool m_bundleStale = true;
+    GraphRenderer m_renderer;
+    uint64_t m_uiVersion = 0;
+    bool m_shownOrientation = false;
+    bool m_showMemory = false;
+
+    sf::CircleShape m_orientationToggle;
+    sf::Text m_toggleText;
+    sf::Text m_helpText;
+    sf::Text m_modeText;
+    sf::Text m_memoryText;
+
+    EdgeHandle m_hoveredEdge;
+    EdgeHandle m_selectedEdge;
+    sf::VertexArray m_edgeHighlights{sf::Triangles};
+
+    const TemporalPlayback* m_playback = nullptr;
+    sf::RectangleShape m_timelineTrack;
+    sf::RectangleShape m_timelineFill;
+    sf::CircleShape m_timelineKnob;
+    sf::Text m_timelineText;
+
+    void drawEdgeHighlights() {
+        m_edgeHighlights.clear();
+        appendEdgeHighlight(m_hoveredEdge, sf::Color(255, 170, 60), 2.f);
+        appendEdgeHighlight(m_selectedEdge, sf::Color(70, 130, 220), 3.f);
+        if (m_edgeHighlights.getVertexCount() > 0) m_window->draw(m_edgeHighlights);
+    }
+
+    void appendEdgeHighlight(EdgeHandle handle, const sf::Color& color, float halfWidth) {
+        const Edge* edge = m_graph.getEdges().get(handle);
+        if (!edge) return;
+        EdgeGeometry geometry = EdgeGeometry::compute(m_graph.getNodes(), *edge);
+        if (!geometry.valid) return;
+
+        sf::Vector2f direction = geometry.lineEnd - geometry.lineStart;
+        float length = std::sqrt(direction.x * direction.x + direction.y * direction.y);
+        if (length <= 0.f) return;
+        sf::Vector2f normal(-direction.y / length * halfWidth, direction.x / length * halfWidth);
+        sf::Vector2f corners[4] = {geometry.lineStart + normal, geometry.lineEnd + normal,
+                                   geometry.lineEnd - normal, geometry.lineStart - normal};
+        for (int i : {0, 1, 2, 0, 2, 3}) m_edgeHighlights.append(sf::Vertex(corners[i], color));
+    }
+
+    void drawTimeline() {
+        sf::Vector2u size = m_window->getSize();
+        sf::FloatRect track = timelineTrack(sf::Vector2f(static_cast<float>(size.x), static_cast<float>(size.y)));
+        float progress = static_cast<float>(m_playback->getProgress());
+
+        m_timelineTrack.setPosition(track.left, track.top);
+        m_timelineTrack.setSize(sf::Vector2f(track.width, track.height));
+        m_timelineFill.setPosition(track.left, track.top);
+        m_timelineFill.setSize(sf::Vector2f(track.width * progress, track.height));
+        m_timelineKnob.setPosition(track.left + track.width * progress, track.top + track.height / 2.f);
+
+        std::ostringstream label;
+        label << std::setprecision(6) << "t = " << m_playback->getTime() << " / " << m_playback->getEndTime()
+              << (m_playback->isPlaying() ? "  (Space pauses)" : "  (Space plays)");
+        m_timelineText.setString(label.str());
+        m_timelineText.setPosition(track.left, track.top - 24.f);
+
+        m_window->draw(m_timelineTrack);
+        m_window->draw(m_timelineFill);
+        m_window->draw(m_timelineKnob);
+        m_window->draw(m_timelineText);
+    }
+
+    void centerText(sf::Text& text, const sf::Vector2f& position) {
+        sf::FloatRect bounds = text.getLocalBounds();
+        text.setOrigin(bounds.left + bounds.width / 2.0f,
+                      bounds.top + bounds.height / 2.0f);
+        text.setPosition(position);
+    }
+
+    void updateToggleAppearance() {
+        m_shownOrientation = m_graph.isOriented();
+        m_orientationToggle.setFillColor(
+            m_shownOrientation ? sf::Color(200, 200, 200) : sf::Color::White);
+        m_toggleText.setString(m_shownOrientation ? "D" : "U");
+        centerText(m_toggleText, m_orientationToggle.getPosition() +
+            sf::Vector2f(m_orientationToggle.getRadius(), m_orientationToggle.getRadius()));
+        ++m_uiVersion;
+    }
+};
@@ -0,0 +1,318 @@
+#pragma once
+#include "Graph.hpp"
+#include "GraphView.hpp"
+#include "Trace.hpp"
+#include <SFML/Graphics.hpp>
+#include <cmath>
+#include <iostream>
+
+// The editing rules of the interactive mode, driven by sf::Events alone
+// (positions come from the events, never from the live mouse), so a
+// recorded event stream reproduces a session with or without a window.
+class Interaction {
+public:
+    static constexpr float kMinDistance = 50.f;
+    static constexpr float kMoveSpeed = 0.3f;
+    // How far from an edge's line a click or hover still picks it.
+    static constexpr float kEdgeTolerance = 6.f;
+
+    // view and window may be null for headless replays; area is the window
+    // size that dragged nodes are kept inside.
+    Interaction(Graph& graph, GraphView* view, const sf::RenderWindow* window, const sf::Vector2u& area)
+        : m_graph(graph), m_view(view), m_window(window),
+          m_area(static_cast<float>(area.x), static_cast<float>(area.y)) {}
+
+    // Makes layouts that normally refine in the background finish before
+    // the event returns, so replays do not depend on thread timing.
+    void setDeterministic(bool deterministic) { m_deterministic = deterministic; }
+
+    void setLogging(bool logging) { m_logging = logging; }
+
+    // Lets Space and the timeline slider drive a temporal playback.
+    void setPlayback(TemporalPlayback* playback) { m_playback = playback; }
+
+    // Returns false when the event asks to quit.
+    bool handleEvent(const sf::Event& event) {
+        switch (event.type) {
+            case sf::Event::Closed:
+                return false;
+
+            case sf::Event::KeyPressed:
+                if (event.key.code == sf::Keyboard::Escape) {
+
+                    if (m_selectedNode) {
+                        m_graph.setNodeHighlighted(m_selectedNode, false);
+                        m_selectedNode = NodeHandle();
+                    }
+                    return false;
+                }
+
+                else if (event.key.code == sf::Keyboard::D) {
+                    m_isDrawingMode = !m_isDrawingMode;
+
+                    if (m_selectedNode) {
+                        m_graph.setNodeHighlighted(m_selectedNode, false);
+                        m_selectedNode = NodeHandle();
+                    }
+                    if (m_view) m_view->updateModeText(m_isDrawingMode);
+                    log() << (m_isDrawingMode ? "Edge Drawing Mode" : "Node Moving Mode") << std::endl;
+                }
+
+                else if (event.key.code == sf::Keyboard::P) {
+                    PageRankResult result = m_graph.applyPageRank(m_selectedNode);
+                    log() << (m_selectedNode ? "Personalised PageRank" : "PageRank")
+                          << (result.converged ? " converged in " : " did not converge in ") << result.iterations
+                          << " iterations (residual " << result.residual << ")" << std::endl;
+                }
+
+                else if (event.key.code == sf::Keyboard::B) {
+                    BetweennessResult result = m_graph.applyBetweenness();
+                    log() << "Betweenness from " << result.sources << " sources";
+                    if (result.errorBound > 0.0) {
+                        log() << " (normalised error <= " << result.errorBound << ")";
+                    }
+                    log() << std::endl;
+                }
+
+                else if (event.key.code == sf::Keyboard::M) {
+                    LouvainResult result = m_graph.applyCommunities();
+                    log() << result.communityCount << " communities, modularity "
+                          << result.modularity << std::endl;
+                }
+
+                else if (event.key.code == sf::Keyboard::L) {
+                    m_graph.applyMultilevelLayout();
+                    log() << "Multilevel layout" << std::endl;
+                }
+
+                else if (event.key.code == sf::Keyboard::S) {
+                    m_graph.applyStressLayout();
+                    if (m_deterministic) m_graph.finishLayoutRefinement();
+                    log() << "Pivot MDS layout, refining stress in the background" << std::endl;
+                }
+
+                else if (event.key.code == sf::Keyboard::E) {
+                    if (m_view) m_view->toggleBundling();
+                    log() << "Toggled edge bundling" << std::endl;
+                }
+
+                else if (event.key.code == sf::Keyboard::I) {
+                    if (m_view) m_view->toggleMemoryOverlay();
+                    log() << "Toggled memory overlay" << std::endl;
+                }
+
+                else if (event.key.code == sf::Keyboard::T) {
+                    if (writeTraceFile("trace.json")) log() << "Wrote trace.json" << std::endl;
+                }
+
+                else if (event.key.code == sf::Keyboard::K) {
+                    TriangleResult result = m_graph.applyClustering();
+                    log() << result.total << " triangles, global clustering " << result.globalClustering
+                          << ", average local " << result.averageClustering
+                          << (result.usedBitset ? " (bitset rows)" : " (merged lists)") << std::endl;
+                }
+
+                else if (event.key.code == sf::Keyboard::C) {
+                    m_graph.applyCloseness();
+                    log() << "Closeness centrality" << std::endl;
+                }
+
+                else if (event.key.code == sf::Keyboard::O) {
+                    OverlapRemovalResult result = m_graph.removeOverlaps();
+                    log() << "Overlaps: " << result.overlapsBefore + result.stacked << " before, "
+                          << result.overlapsAfter << " remaining after " << result.iterations << " rounds"
+                          << std::endl;
+                }
+
+                else if (event.key.code == sf::Keyboard::Space) {
+                    if (m_playback) {
+                        m_playback->setPlaying(!m_playback->isPlaying());
+                        log() << (m_playback->isPlaying() ? "Playing" : "Paused") << " at t = "
+                              << m_playback->getTime() << std::endl;
+                    }
+                }
+
+                else if (event.key.code == sf::Keyboard::Delete) {
+                    // The selected edge or node, or else what is under the pointer.
+                    EdgeHandle edge = m_selectedEdge ? m_selectedEdge : m_selectedNode ? EdgeHandle() : edgeAt(m_pointer);
+                    selectEdge(EdgeHandle());
+                    if (m_graph.removeEdge(edge)) {
+                        log() << "Deleted edge" << std::endl;
+                        break;
+                    }
+                    NodeHandle target = m_selectedNode ? m_selectedNode : m_graph.findNodeAt(m_pointer);
+                    if (target == m_draggedNode) {
+                        m_draggedNode = NodeHandle();
+                        m_isDragging = false;
+                    }
+                    if (m_graph.removeNode(target)) {
+                        if (target == m_selectedNode) m_selectedNode = NodeHandle();
+                        log() << "Deleted node" << std::endl;
+                    }
+                }
+                break;
+
+            case sf::Event::MouseButtonPressed: {
+                if (event.mouseButton.button == sf::Mouse::Left) {
+                    sf::Vector2f mousePos = toWorld(event.mouseButton.x, event.mouseButton.y);
+
+                    if (m_playback && hitsTimeline(mousePos)) {
+                        m_isScrubbing = true;
+                        scrubTo(mousePos);
+                        break;
+                    }
+
+                    if (GraphView::hitsOrientationToggle(mousePos)) {
+                        m_graph.toggleOrientation();
+                        break;
+                    }
+
+                    NodeHandle clicked = m_graph.findNodeAt(mousePos);
+                    bool nodeClicked = clicked.isValid();
+
+                    // A click on an edge selects it (for Delete) rather than
+                    // placing a node on it.
+                    EdgeHandle clickedEdge = nodeClicked ? EdgeHandle() : m_graph.findEdgeAt(mousePos, kEdgeTolerance);
+                    selectEdge(clickedEdge);
+                    if (clickedEdge) break;
+
+                    if (nodeClicked) {
+                        if (m_isDrawingMode) {
+                            if (!m_selectedNode) {
+
+                                m_selectedNode = clicked;
+                                m_graph.setNodeHighlighted(m_selectedNode, true);
+                            } else if (clicked != m_selectedNode) {
+
+                                m_graph.addEdge(m_selectedNode, clicked);
+
+                                m_graph.setNodeHighlighted(m_selectedNode, false);
+                                m_selectedNode = NodeHandle();
+                            }
+                        } else {
+
+                            m_graph.stopLayoutRefinement();
+                            m_draggedNode = clicked;
+                            m_isDragging = true;
+                            m_graph.beginDrag(m_draggedNode);
+                        }
+                    }
+
+
+                    if (!nodeClicked && !m_isDrawingMode) {
+                        m_graph.addNode(mousePos);
+                    }
+                }
+
+                else if (event.mouseButton.button == sf::Mouse::Right) {
+                    selectEdge(EdgeHandle());
+                    if (m_selectedNode) {
+                        m_graph.setNodeHighlighted(m_selectedNode, false);
+                        m_selectedNode = NodeHandle();
+                    }
+                }
+                break;
+            }
+
+            case sf::Event::MouseButtonReleased:
+                if (event.mouseButton.button == sf::Mouse::Left) {
+                    m_isScrubbing = false;
+                    if (m_isDragging && m_draggedNode) {
+                        m_graph.endDrag();
+                        m_draggedNode = NodeHandle();
+                        m_isDragging = false;
+                    }
+                }
+                break;
+
+            case sf::Event::MouseMoved:
+                m_pointer = toWorld(event.mouseMove.x, event.mouseMove.y);
+                if (m_isScrubbing) scrubTo(m_pointer);
+                if (m_view) m_view->setHoveredEdge(canHover() ? edgeAt(m_pointer) : EdgeHandle());
+                if (m_isDragging && m_draggedNode) {
+                    sf::Vector2f mousePos = toWorld(event.mouseMove.x, event.mouseMove.y);
+                    bool canMove = m_graph.isPositionValid(mousePos, kMinDistance, m_draggedNode);
+
+
+                    if (canMove) {
+                        sf::Vector2f currentPos = m_graph.getNodePosition(m_draggedNode);
+                        sf::Vector2f direction = mousePos - currentPos;
+                        float length = std::sqrt(direction.x * direction.x + direction.y * direction.y);
+
+                        if (length > 0) {
+                            direction /= length;
+                            sf::Vector2f newPos = currentPos + direction * kMoveSpeed * length;
+
+
+                            newPos.x = std::max(20.f, std::min(newPos.x, m_area.x - 20.f));
+                            newPos.y = std::max(20.f, std::min(newPos.y, m_area.y - 20.f));
+
+                            m_graph.setNodePosition(m_draggedNode, newPos);
+                        }
+                    }
+                }
+                break;
+        }
+        return true;
+    }
+
+private:
+    Graph& m_graph;
+    GraphView* m_view;
+    const sf::RenderWindow* m_window;
+    sf::Vector2f m_area;
+    bool m_deterministic = false;
+    bool m_logging = true;
+    // No stream buffer: everything written to it is dropped.
+    std::ostream m_discard{nullptr};
+
+    NodeHandle m_draggedNode;
+    NodeHandle m_selectedNode;
+    EdgeHandle m_selectedEdge;
+    // Last pointer position seen in a move event, for keyboard actions.
+    sf::Vector2f m_pointer;
+    TemporalPlayback* m_playback = nullptr;
+    bool m_isScrubbing = false;
+    bool m_isDragging = false;
+    bool m_isDrawingMode = false;
+
+    sf::Vector2f toWorld(int x, int y) const {
+        if (!m_window) return sf::Vector2f(static_cast<float>(x), static_cast<float>(y));
+        return m_window->mapPixelToCoords(sf::Vector2i(x, y));
+    }
+
+    // The edge under point, unless a node covers it.
+    EdgeHandle edgeAt(const sf::Vector2f& point) {
+        return m_graph.findNodeAt(point) ? EdgeHandle() : m_graph.findEdgeAt(point, kEdgeTolerance);
+    }
+
+    // Hovering is off while positions stream in from a layout or a playing
+    // timeline: every frame moves all nodes, so each lookup would re-index
+    // the whole graph. It resumes with the first move after they settle.
+    bool canHover() const {
+        return !m_isDragging && !m_isScrubbing && !m_graph.isLayoutRunning() &&
+               !(m_playback && m_playback->isAnimating());
+    }
+
+    void selectEdge(EdgeHandle edge) {
+        m_selectedEdge = edge;
+        if (m_view) m_view->setSelectedEdge(edge);
+    }
+
+    // The slider's track, with some slack above and below to grab it by.
+    bool hitsTimeline(const sf::Vector2f& point) const {
+        sf::FloatRect track = GraphView::timelineTrack(m_area);
+        return point.x >= track.left - 8.f && point.x <= track.left + track.width + 8.f &&
+               point.y >= track.top - 10.f && point.y <= track.top + track.height + 10.f;
+    }
+
+    void scrubTo(const sf::Vector2f& point) {
+        sf::FloatRect track = GraphView::timelineTrack(m_area);
+        double fraction = std::min(std::max((point.x - track.left) / track.width, 0.f), 1.f);
+        m_playback->seek(m_playback->getStartTime() + fraction * (m_playback->getEndTime() - m_playback->getStartTime()));
+    }
+
+    std::ostream& log() {
+        return m_logging ? std::cout : m_discard;
+    }
+};
@@ -0,0 +1,101 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Open-addressing map from 64-bit keys to 32-bit values (handle values,
+// dense indices). Linear probing over one flat array keeps a lookup to a
+// cache line or two, where a node-based unordered_map costs an allocation
+// per insert and a pointer chase per probe. Erase shifts the following run
+// back instead of leaving tombstones, so lookups never slow down with churn.
+// UINT64_MAX is reserved as the empty key.
+class KeyIndex {
+public:
+    static constexpr uint64_t kEmpty = UINT64_MAX;
+    static constexpr uint32_t kMissing = UINT32_MAX;
+
+    uint32_t find(uint64_t key) const {
+        if (m_entries.empty()) return kMissing;
+        for (size_t i = home(key);; i = (i + 1) & m_mask) {
+            if (m_entries[i].key == key) return m_entries[i].value;
+            if (m_entries[i].key == kEmpty) return kMissing;
+        }
+    }
+
+    // Inserts the key or overwrites its value.
+    void insert(uint64_t key, uint32_t value) {
+        if ((m_size + 1) * 2 > m_entries.size()) rehash(m_entries.size() ? m_entries.size() * 2 : 16);
+        size_t i = home(key);
+        while (m_entries[i].key != kEmpty && m_entries[i].key != key) i = (i + 1) & m_mask;
+        if (m_entries[i].key == kEmpty) ++m_size;
+        m_entries[i] = {key, value};
+    }
+
+    bool erase(uint64_t key) {
+        if (m_entries.empty()) return false;
+        size_t i = home(key);
+        while (m_entries[i].key != key) {
+            if (m_entries[i].key == kEmpty) return false;
+            i = (i + 1) & m_mask;
+        }
+
+        // Pull back every later entry of the run whose home slot does not
+        // lie cyclically in (i, j], so none becomes unreachable.
+        for (size_t j = (i + 1) & m_mask; m_entries[j].key != kEmpty; j = (j + 1) & m_mask) {
+            size_t k = home(m_entries[j].key);
+            bool stays = i < j ? (k > i && k <= j) : (k > i || k <= j);
+            if (!stays) {
+                m_entries[i] = m_entries[j];
+                i = j;
+            }
+        }
+        m_entries[i].key = kEmpty;
+        --m_size;
+        return true;
+    }
+
+    void reserve(size_t count) {
+        size_t capacity = 16;
+        while (capacity < count * 2) capacity <<= 1;
+        if (capacity > m_entries.size()) rehash(capacity);
+    }
+
+    void clear() {
+        m_entries.clear();
+        m_size = 0;
+        m_mask = 0;
+    }
+
+    size_t size() const { return m_size; }
+    size_t memoryBytes() const { return m_entries.capacity() * sizeof(Entry); }
+
+private:
+    struct Entry {
+        uint64_t key = kEmpty;
+        uint32_t value = 0;
+    };
+
+    std::vector<Entry> m_entries;
+    size_t m_size = 0;
+    size_t m_mask = 0;
+    int m_shift = 64;
+
+    // Fibonacci hashing: the multiply spreads sequential ids and packed
+    // handle pairs, and the top bits pick the slot.
+    size_t home(uint64_t key) const {
+        return static_cast<size_t>((key * 0x9E3779B97F4A7C15ull) >> m_shift);
+    }
+
+    void rehash(size_t capacity) {
+        std::vector<Entry> old;
+        old.swap(m_entries);
+        m_entries.assign(capacity, Entry());
+        m_mask = capacity - 1;
+        m_shift = 64;
+        for (size_t c = capacity; c > 1; c >>= 1) --m_shift;
+        m_size = 0;
+        for (const Entry& entry : old) {
+            if (entry.key != kEmpty) insert(entry.key, entry.value);
+        }
+    }
+};
@@ -0,0 +1,165 @@
+#pragma once
+#include "Csr.hpp"
+#include "Parallel.hpp"
+#include <algorithm>
+#include <numeric>
+#include <unordered_map>
+
+struct LouvainOptions {
+    int maxLevels = 10;
+    int maxSweeps = 32;
+    double minGain = 1e-6;
+};
+
+struct LouvainResult {
+    std::vector<uint32_t> community;
+    size_t communityCount = 0;
+    double modularity = 0.0;
+    int levels = 0;
+    // One node per community, edge weights summed across communities; this is
+    // what a level-of-detail view collapses to.
+    WeightedCsr superGraph;
+};
+
+class Louvain {
+public:
+    explicit Louvain(const LouvainOptions& options = {}) : m_options(options) {}
+
+    LouvainResult run(const CsrGraph& graph) {
+        LouvainResult result;
+        const size_t n = graph.nodeCount();
+        result.community.resize(n);
+        std::iota(result.community.begin(), result.community.end(), 0u);
+        result.superGraph = WeightedCsr::fromCsr(graph);
+        if (n == 0 || graph.edgeCount() == 0) {
+            result.communityCount = n;
+            return result;
+        }
+
+        WeightedCsr level = result.superGraph;
+        for (result.levels = 0; result.levels < m_options.maxLevels; ++result.levels) {
+            std::vector<uint32_t> membership = moveNodes(level);
+            size_t count = renumber(membership);
+            if (count == level.nodeCount()) break;
+
+            for (uint32_t& c : result.community) c = membership[c];
+            level = level.contracted(membership, count);
+        }
+
+        result.superGraph = level;
+        result.communityCount = level.nodeCount();
+        result.modularity = modularity(level);
+        return result;
+    }
+
+private:
+    LouvainOptions m_options;
+
+    static std::vector<double> degrees(const WeightedCsr& graph) {
+        std::vector<double> k(graph.nodeCount(), 0.0);
+        parallelFor(graph.nodeCount(), [&](size_t begin, size_t end, unsigned) {
+            for (size_t u = begin; u < end; ++u) {
+                for (uint32_t e = graph.offsets[u]; e < graph.offsets[u + 1]; ++e) {
+                    k[u] += graph.weights[e];
+                }
+            }
+        });
+        return k;
+    }
+
+    // Local moving phase. Each sweep decides the best community of every node
+    // in parallel against a snapshot of the partition, then applies the moves.
+    // Two singletons may only merge towards the lower id, which stops pairs
+    // from swapping places forever.
+    std::vector<uint32_t> moveNodes(const WeightedCsr& graph) const {
+        const size_t n = graph.nodeCount();
+        std::vector<double> k = degrees(graph);
+        double m2 = std::accumulate(k.begin(), k.end(), 0.0);
+
+        std::vector<uint32_t> community(n);
+        std::iota(community.begin(), community.end(), 0u);
+        std::vector<double> total = k;
+        std::vector<uint32_t> size(n, 1);
+        std::vector<uint32_t> target(n);
+        std::vector<double> gains(workerCount(), 0.0);
+
+        for (int sweep = 0; sweep < m_options.maxSweeps; ++sweep) {
+            std::fill(gains.begin(), gains.end(), 0.0);
+
+            parallelFor(n, [&](size_t begin, size_t end, unsigned worker) {
+                std::unordered_map<uint32_t, double> links;
+                for (size_t u = begin; u < end; ++u) {
+                    links.clear();
+                    uint32_t current = community[u];
+                    links[current] = 0.0;
+                    for (uint32_t e = graph.offsets[u]; e < graph.offsets[u + 1]; ++e) {
+                        if (graph.targets[e] != u) {
+                            links[community[graph.targets[e]]] += graph.weights[e];
+                        }
+                    }
+
+                    double stay = links[current] - k[u] * (total[current] - k[u]) / m2;
+                    uint32_t best = current;
+                    double bestGain = stay;
+                    for (const auto& [c, weight] : links) {
+                        if (c == current) continue;
+                        double gain = weight - k[u] * total[c] / m2;
+                        if (gain > bestGain || (gain == bestGain && c < best)) {
+                            best = c;
+                            bestGain = gain;
+                        }
+                    }
+
+                    if (best != current && size[current] == 1 && size[best] == 1 && best > current) {
+                        best = current;
+                    }
+                    target[u] = best;
+                    if (best != current) gains[worker] += (bestGain - stay) / m2;
+                }
+            });
+
+            bool moved = false;
+            for (size_t u = 0; u < n; ++u) {
+                uint32_t from = community[u];
+                uint32_t to = target[u];
+                if (from == to) continue;
+                total[from] -= k[u];
+                total[to] += k[u];
+                --size[from];
+                ++size[to];
+                community[u] = to;
+                moved = true;
+            }
+
+            double gain = std::accumulate(gains.begin(), gains.end(), 0.0);
+            if (!moved || gain < m_options.minGain) break;
+        }
+        return community;
+    }
+
+    static size_t renumber(std::vector<uint32_t>& membership) {
+        std::vector<uint32_t> id(membership.size(), UINT32_MAX);
+        uint32_t next = 0;
+        for (uint32_t& c : membership) {
+            if (id[c] == UINT32_MAX) id[c] = next++;
+            c = id[c];
+        }
+        return next;
+    }
+
+    // Modularity of the partition where every node of graph is a community.
+    static double modularity(const WeightedCsr& graph) {
+        std::vector<double> k = degrees(graph);
+        double m2 = std::accumulate(k.begin(), k.end(), 0.0);
+        if (m2 <= 0.0) return 0.0;
+
+        double q = 0.0;
+        for (size_t c = 0; c < graph.nodeCount(); ++c) {
+            for (uint32_t e = graph.offsets[c]; e < graph.offsets[c + 1]; ++e) {
+                if (graph.targets[e] == c) q += graph.weights[e] / m2;
+            }
+            q -= (k[c] / m2) * (k[c] / m2);
+        }
+        return q;
+    }
+};
@@ -0,0 +1,103 @@
+#pragma once
+#include <SFML/Graphics.hpp>
+#include <cstddef>
+#include <cstdio>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Heap bytes and object counts for one subsystem. Containers report their
+// capacity rather than their size, since that is what the process holds;
+// vertex arrays, which do not expose their capacity, report their size.
+struct MemoryUsage {
+    size_t bytes = 0;
+    size_t objects = 0;
+
+    MemoryUsage& operator+=(const MemoryUsage& other) {
+        bytes += other.bytes;
+        objects += other.objects;
+        return *this;
+    }
+};
+
+template <typename T>
+size_t heapBytes(const std::vector<T>& values) {
+    return values.capacity() * sizeof(T);
+}
+
+// Vertices in use, a lower bound on what the array holds.
+inline size_t vertexBytes(const sf::VertexArray& vertices) {
+    return vertices.getVertexCount() * sizeof(sf::Vertex);
+}
+
+// RGBA8 pixels; SFML keeps textures on the GPU, but they still have to be
+// paid for somewhere.
+inline size_t textureBytes(const sf::Texture& texture) {
+    return static_cast<size_t>(texture.getSize().x) * texture.getSize().y * 4;
+}
+
+// Per-subsystem totals, as shown by the memory overlay (press I) and
+// written by --memory and --metrics.
+class MemoryReport {
+public:
+    void add(const std::string& subsystem, const MemoryUsage& usage) {
+        for (auto& entry : m_entries) {
+            if (entry.first == subsystem) {
+                entry.second += usage;
+                return;
+            }
+        }
+        m_entries.emplace_back(subsystem, usage);
+    }
+
+    bool empty() const { return m_entries.empty(); }
+    const std::vector<std::pair<std::string, MemoryUsage>>& getEntries() const { return m_entries; }
+
+    MemoryUsage total() const {
+        MemoryUsage sum;
+        for (const auto& entry : m_entries) sum += entry.second;
+        return sum;
+    }
+
+    // {"nodes": {"bytes": 1234, "objects": 10}, ..., "total": {...}}
+    void writeJson(std::ostream& out) const {
+        out << '{';
+        for (const auto& entry : m_entries) {
+            out << '"' << entry.first << "\": {\"bytes\": " << entry.second.bytes
+                << ", \"objects\": " << entry.second.objects << "}, ";
+        }
+        MemoryUsage sum = total();
+        out << "\"total\": {\"bytes\": " << sum.bytes << ", \"objects\": " << sum.objects << "}}";
+    }
+
+    // One aligned line per subsystem, for the overlay.
+    std::string toText() const {
+        std::string text;
+        char line[96];
+        for (const auto& entry : m_entries) {
+            std::snprintf(line, sizeof(line), "%-10s %10s %9zu\n", entry.first.c_str(),
+                          formatBytes(entry.second.bytes).c_str(), entry.second.objects);
+            text += line;
+        }
+        MemoryUsage sum = total();
+        std::snprintf(line, sizeof(line), "%-10s %10s %9zu", "total", formatBytes(sum.bytes).c_str(), sum.objects);
+        return text + line;
+    }
+
+    static std::string formatBytes(size_t bytes) {
+        const char* units[] = {"B", "KiB", "MiB", "GiB"};
+        double value = static_cast<double>(bytes);
+        int unit = 0;
+        while (value >= 1024.0 && unit < 3) {
+            value /= 1024.0;
+            ++unit;
+        }
+        char text[32];
+        std::snprintf(text, sizeof(text), unit ? "%.1f %s" : "%.0f %s", value, units[unit]);
+        return text;
+    }
+
+private:
+    std::vector<std::pair<std::string, MemoryUsage>> m_entries;
+};
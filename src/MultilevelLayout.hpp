@@ -0,0 +1,218 @@
+#pragma once
+#include "Csr.hpp"
+#include "Parallel.hpp"
+#include "SpatialGrid.hpp"
+#include <limits>
+#include <numeric>
+#include <random>
+
+struct MultilevelLayoutOptions {
+    // Ideal edge length K of the spring-electrical model.
+    float naturalLength = 60.f;
+    size_t coarsestSize = 50;
+    int coarsestIterations = 300;
+    int refineIterations = 40;
+    unsigned seed = 7;
+};
+
+// sfdp-style multilevel layout: coarsen by heavy-edge matching (collapsing
+// leftover nodes into a heavy neighbour), lay out the coarsest graph, then
+// prolong positions to each finer level and refine them with a few
+// spring-electrical iterations. Repulsion is cut off at a few K and found
+// through a uniform grid, so every iteration is linear in n + m.
+class MultilevelLayout {
+public:
+    explicit MultilevelLayout(const MultilevelLayoutOptions& options = {})
+        : m_options(options), m_rng(options.seed) {}
+
+    std::vector<sf::Vector2f> run(const CsrGraph& graph) {
+        std::vector<Level> levels(1);
+        levels[0].graph = WeightedCsr::fromCsr(graph);
+        levels[0].mass.assign(graph.nodeCount(), 1.f);
+        if (graph.nodeCount() == 0) return {};
+
+        while (levels.back().graph.nodeCount() > m_options.coarsestSize) {
+            Level& fine = levels.back();
+            size_t count = 0;
+            fine.parent = coarsen(fine, count);
+            if (count > fine.graph.nodeCount() * 9 / 10) {
+                fine.parent.clear();
+                break;
+            }
+
+            Level coarse;
+            coarse.graph = fine.graph.contracted(fine.parent, count);
+            coarse.mass.assign(count, 0.f);
+            for (size_t u = 0; u < fine.parent.size(); ++u) {
+                coarse.mass[fine.parent[u]] += fine.mass[u];
+            }
+            levels.push_back(std::move(coarse));
+        }
+
+        const float k = m_options.naturalLength;
+        std::uniform_real_distribution<float> spread(0.f, k * std::sqrt(static_cast<float>(levels.back().graph.nodeCount())));
+        std::vector<sf::Vector2f> positions(levels.back().graph.nodeCount());
+        for (auto& p : positions) p = sf::Vector2f(spread(m_rng), spread(m_rng));
+        refine(levels.back(), positions, m_options.coarsestIterations, k * 2.f);
+
+        std::uniform_real_distribution<float> jitter(-0.1f * k, 0.1f * k);
+        for (size_t l = levels.size() - 1; l-- > 0;) {
+            const Level& fine = levels[l];
+            float scale = std::sqrt(static_cast<float>(fine.graph.nodeCount()) / positions.size());
+
+            std::vector<sf::Vector2f> prolonged(fine.graph.nodeCount());
+            for (size_t u = 0; u < prolonged.size(); ++u) {
+                prolonged[u] = positions[fine.parent[u]] * scale + sf::Vector2f(jitter(m_rng), jitter(m_rng));
+            }
+            positions = std::move(prolonged);
+            refine(fine, positions, m_options.refineIterations, k * 0.5f);
+        }
+        return positions;
+    }
+
+    // A few finest-level iterations starting from given positions, with a
+    // small step, so a slightly changed graph keeps its previous shape.
+    std::vector<sf::Vector2f> refineFrom(const CsrGraph& graph, std::vector<sf::Vector2f> positions, int iterations) {
+        if (positions.size() != graph.nodeCount() || positions.empty()) return positions;
+        Level level;
+        level.graph = WeightedCsr::fromCsr(graph);
+        level.mass.assign(graph.nodeCount(), 1.f);
+        refine(level, positions, iterations, m_options.naturalLength * 0.25f);
+        return positions;
+    }
+
+private:
+    struct Level {
+        WeightedCsr graph;
+        std::vector<float> mass;
+        // Index of the node in the next coarser level that this node maps to.
+        std::vector<uint32_t> parent;
+    };
+
+    MultilevelLayoutOptions m_options;
+    std::mt19937 m_rng;
+
+    std::vector<uint32_t> coarsen(const Level& level, size_t& count) {
+        const WeightedCsr& graph = level.graph;
+        const size_t n = graph.nodeCount();
+        std::vector<uint32_t> group(n, UINT32_MAX);
+        std::vector<uint32_t> groupSize;
+        std::vector<uint32_t> order(n);
+        std::iota(order.begin(), order.end(), 0u);
+        std::shuffle(order.begin(), order.end(), m_rng);
+
+        for (uint32_t u : order) {
+            if (group[u] != UINT32_MAX) continue;
+            uint32_t best = UINT32_MAX;
+            double bestWeight = 0.0;
+            for (uint32_t e = graph.offsets[u]; e < graph.offsets[u + 1]; ++e) {
+                uint32_t v = graph.targets[e];
+                if (v == u || group[v] != UINT32_MAX) continue;
+                double weight = graph.weights[e] / (level.mass[u] * level.mass[v]);
+                if (weight > bestWeight) {
+                    bestWeight = weight;
+                    best = v;
+                }
+            }
+            if (best != UINT32_MAX) {
+                group[u] = group[best] = static_cast<uint32_t>(groupSize.size());
+                groupSize.push_back(2);
+            }
+        }
+
+        // Nodes left unmatched (star centres' leaves, mostly) join the group of
+        // their heaviest neighbour, so stars still shrink.
+        for (uint32_t u : order) {
+            if (group[u] != UINT32_MAX) continue;
+            uint32_t best = UINT32_MAX;
+            double bestWeight = 0.0;
+            for (uint32_t e = graph.offsets[u]; e < graph.offsets[u + 1]; ++e) {
+                uint32_t v = graph.targets[e];
+                if (v == u || group[v] == UINT32_MAX || groupSize[group[v]] >= 4) continue;
+                if (graph.weights[e] > bestWeight) {
+                    bestWeight = graph.weights[e];
+                    best = v;
+                }
+            }
+            if (best != UINT32_MAX) {
+                group[u] = group[best];
+                ++groupSize[group[u]];
+            } else {
+                group[u] = static_cast<uint32_t>(groupSize.size());
+                groupSize.push_back(1);
+            }
+        }
+
+        count = groupSize.size();
+        return group;
+    }
+
+    void refine(const Level& level, std::vector<sf::Vector2f>& positions, int iterations, float step) {
+        const WeightedCsr& graph = level.graph;
+        const size_t n = positions.size();
+        const float k = m_options.naturalLength;
+        const float cutoff = 3.f * k;
+
+        SpatialGrid grid;
+        std::vector<sf::Vector2f> displacement(n);
+        std::vector<double> partialEnergy(workerCount());
+        double previousEnergy = std::numeric_limits<double>::max();
+        int progress = 0;
+
+        for (int iteration = 0; iteration < iterations; ++iteration) {
+            grid.build(positions, cutoff);
+            std::fill(partialEnergy.begin(), partialEnergy.end(), 0.0);
+
+            parallelFor(n, [&](size_t begin, size_t end, unsigned worker) {
+                double energy = 0.0;
+                for (size_t u = begin; u < end; ++u) {
+                    sf::Vector2f force;
+                    const sf::Vector2f pu = positions[u];
+
+                    grid.forEachNear(pu, cutoff, [&](uint32_t v) {
+                        if (v == u) return;
+                        sf::Vector2f delta = pu - positions[v];
+                        float d2 = delta.x * delta.x + delta.y * delta.y;
+                        if (d2 > cutoff * cutoff) return;
+                        if (d2 < 1e-4f) {
+                            delta = sf::Vector2f(u < v ? 0.01f : -0.01f, 0.01f);
+                            d2 = 2e-4f;
+                        }
+                        force += delta * (level.mass[v] * k * k / d2);
+                    });
+
+                    for (uint32_t e = graph.offsets[u]; e < graph.offsets[u + 1]; ++e) {
+                        uint32_t v = graph.targets[e];
+                        if (v == u) continue;
+                        sf::Vector2f delta = positions[v] - pu;
+                        float d = std::sqrt(delta.x * delta.x + delta.y * delta.y);
+                        force += delta * (d / k);
+                    }
+
+                    float length = std::sqrt(force.x * force.x + force.y * force.y);
+                    energy += length * length;
+                    displacement[u] = length > 0.f ? force * (step / length) : sf::Vector2f();
+                }
+                partialEnergy[worker] = energy;
+            });
+
+            for (size_t u = 0; u < n; ++u) {
+                positions[u] += displacement[u];
+            }
+
+            // Adaptive cooling (Hu 2005): grow the step after sustained
+            // progress, shrink it as soon as the energy goes up.
+            double energy = std::accumulate(partialEnergy.begin(), partialEnergy.end(), 0.0);
+            if (energy < previousEnergy) {
+                if (++progress >= 5) {
+                    progress = 0;
+                    step /= 0.9f;
+                }
+            } else {
+                progress = 0;
+                step *= 0.9f;
+            }
+            previousEnergy = energy;
+        }
+    }
+};
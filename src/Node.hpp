@@ -1,63 +1,168 @@
 #pragma once
 #include "SFML/Graphics.hpp"
+#include "CopyOnWrite.hpp"
+#include "Memory.hpp"
+#include "SlotMap.hpp"
 #include <iostream>
 
-class Node {
+struct NodeTag;
+using NodeHandle = Handle<NodeTag>;
+
+enum NodeFlags : uint8_t {
+    NodeHighlighted = 1 << 0,
+};
+
+// Node state as parallel columns indexed by dense position; handles map to
+// dense indices through a SlotIndex. Nothing here owns an SFML drawable: the
+// renderer generates circle and label geometry from these columns, so hot
+// loops (hit testing, layout, culling) only stream the floats they need.
+class NodeStore {
 public:
-    Node(uint8_t id, sf::Vector2f pos, const sf::Font& font)
-        : m_id(id), m_position(pos) {
+    static constexpr float kDefaultRadius = 20.f;
+    static sf::Color defaultColor() { return sf::Color(52, 235, 168); }
+
+    NodeHandle add(uint32_t id, const sf::Vector2f& pos) {
+        m_ids.write().push_back(id);
+        m_x.write().push_back(pos.x);
+        m_y.write().push_back(pos.y);
+        m_radius.write().push_back(kDefaultRadius);
+        m_color.write().push_back(defaultColor());
+        m_flags.write().push_back(0);
+        m_community.write().push_back(0);
+        ++m_version;
+        return m_index.write().allocate();
+    }
+
+    bool remove(NodeHandle handle) {
+        if (!m_index.read().contains(handle)) return false;
+        auto release = m_index.write().release(handle);
+        swapRemove(m_ids.write(), release.removed, release.moved);
+        swapRemove(m_x.write(), release.removed, release.moved);
+        swapRemove(m_y.write(), release.removed, release.moved);
+        swapRemove(m_radius.write(), release.removed, release.moved);
+        swapRemove(m_color.write(), release.removed, release.moved);
+        swapRemove(m_flags.write(), release.removed, release.moved);
+        swapRemove(m_community.write(), release.removed, release.moved);
+        ++m_version;
+        return true;
+    }
+
+    // Empties the store without retiring slots; old handles stay stale (see
+    // SlotIndex::clear).
+    void clear() {
+        m_index.write().clear();
+        m_ids.reset();
+        m_x.reset();
+        m_y.reset();
+        m_radius.reset();
+        m_color.reset();
+        m_flags.reset();
+        m_community.reset();
+        ++m_version;
+        ++m_positionVersion;
+    }
 
-        m_circle.setRadius(20.f);
-        m_circle.setFillColor(sf::Color(52, 235, 168));
-        m_circle.setOutlineColor(sf::Color::Black);
-        m_circle.setOutlineThickness(1.f);
-        m_circle.setOrigin(m_circle.getRadius(), m_circle.getRadius());
-        m_circle.setPosition(m_position);
+    void reserve(size_t count) {
+        m_index.write().reserve(count);
+        m_ids.write().reserve(count);
+        m_x.write().reserve(count);
+        m_y.write().reserve(count);
+        m_radius.write().reserve(count);
+        m_color.write().reserve(count);
+        m_flags.write().reserve(count);
+        m_community.write().reserve(count);
+    }
+
+    MemoryUsage memoryUsage() const {
+        MemoryUsage usage;
+        usage.bytes = m_index.read().memoryBytes() + heapBytes(m_ids.read()) + heapBytes(m_x.read()) +
+                      heapBytes(m_y.read()) + heapBytes(m_radius.read()) + heapBytes(m_color.read()) +
+                      heapBytes(m_flags.read()) + heapBytes(m_community.read());
+        usage.objects = size();
+        return usage;
+    }
+
+    size_t size() const { return m_x.read().size(); }
+    bool empty() const { return m_x.read().empty(); }
+    bool contains(NodeHandle handle) const { return m_index.read().contains(handle); }
+    int64_t indexOf(NodeHandle handle) const { return m_index.read().indexOf(handle); }
+    NodeHandle handleAt(size_t i) const { return m_index.read().handleAt(i); }
 
+    // Bumped on every mutation so cached geometry knows when to rebuild.
+    uint64_t getVersion() const { return m_version; }
 
-        m_text.setFont(font);
-        m_text.setString(std::to_string(m_id));
-        m_text.setCharacterSize(20);
-        m_text.setFillColor(sf::Color::Black);
+    // Bumped only when a node moves, for indices over positions.
+    uint64_t getPositionVersion() const { return m_positionVersion; }
 
+    uint32_t getId(size_t i) const { return m_ids.read()[i]; }
+    sf::Vector2f getPosition(size_t i) const { return sf::Vector2f(m_x.read()[i], m_y.read()[i]); }
+    float getRadius(size_t i) const { return m_radius.read()[i]; }
+    sf::Color getColor(size_t i) const { return m_color.read()[i]; }
+    uint32_t getCommunity(size_t i) const { return m_community.read()[i]; }
+    bool isHighlighted(size_t i) const { return (m_flags.read()[i] & NodeHighlighted) != 0; }
 
-        sf::FloatRect textBounds = m_text.getLocalBounds();
-        m_text.setOrigin(textBounds.left + textBounds.width / 2,
-                        textBounds.top + textBounds.height / 2);
-        m_text.setPosition(m_circle.getPosition());
+    const std::vector<float>& getX() const { return m_x.read(); }
+    const std::vector<float>& getY() const { return m_y.read(); }
+    const std::vector<float>& getRadii() const { return m_radius.read(); }
+
+    void setPosition(size_t i, const sf::Vector2f& pos) {
+        m_x.write()[i] = pos.x;
+        m_y.write()[i] = pos.y;
+        ++m_version;
+        ++m_positionVersion;
     }
 
-    bool containsPoint(const sf::Vector2f& point) const {
-        float dx = point.x - m_position.x;
-        float dy = point.y - m_position.y;
-        return (dx * dx + dy * dy) <= (m_circle.getRadius() * m_circle.getRadius());
+    void setRadius(size_t i, float radius) {
+        m_radius.write()[i] = radius;
+        ++m_version;
     }
 
-    sf::Vector2f getOrigin() const { return m_circle.getOrigin(); }
-    uint8_t getId() const { return m_id; }
-    sf::Vector2f getPosition() const { return m_circle.getPosition(); }
-    sf::CircleShape& getCircle() { return m_circle; }
+    void setColor(size_t i, const sf::Color& color) {
+        m_color.write()[i] = color;
+        ++m_version;
+    }
 
-    void setPosition(const sf::Vector2f& newPos) {
-        m_position = newPos;
-        m_circle.setPosition(m_position);
-        m_text.setPosition(m_position);
+    void setCommunity(size_t i, uint32_t community) {
+        m_community.write()[i] = community;
     }
 
-    void drawNode(sf::RenderWindow& window) {
-        window.draw(m_circle);
-        window.draw(m_text);
+    void setHighlighted(size_t i, bool highlighted) {
+        uint8_t& flags = m_flags.write()[i];
+        flags = highlighted ? (flags | NodeHighlighted) : (flags & ~NodeHighlighted);
+        ++m_version;
     }
 
-    void setHighlighted(bool highlighted) {
-        m_circle.setFillColor(highlighted ?
-            sf::Color(52, 235, 170, 200) : sf::Color(52, 235, 168));
-        m_circle.setOutlineThickness(highlighted ? 2.f : 1.f);
+    // Dense index of the first node whose circle contains point, or -1.
+    int64_t hitTest(const sf::Vector2f& point) const {
+        const std::vector<float>& xs = m_x.read();
+        const std::vector<float>& ys = m_y.read();
+        const std::vector<float>& radii = m_radius.read();
+        for (size_t i = 0; i < xs.size(); ++i) {
+            float dx = point.x - xs[i];
+            float dy = point.y - ys[i];
+            if (dx * dx + dy * dy <= radii[i] * radii[i]) return static_cast<int64_t>(i);
+        }
+        return -1;
     }
 
 private:
-    uint8_t m_id;
-    sf::Text m_text;
-    sf::CircleShape m_circle;
-    sf::Vector2f m_position;
-};
\ No newline at end of file
+    // Columns are shared between copies until written, so copying a store
+    // (for the render worker, say) is O(1) and only the columns changed
+    // afterwards get cloned.
+    CopyOnWrite<SlotIndex<NodeTag>> m_index;
+    CopyOnWrite<std::vector<uint32_t>> m_ids;
+    CopyOnWrite<std::vector<float>> m_x;
+    CopyOnWrite<std::vector<float>> m_y;
+    CopyOnWrite<std::vector<float>> m_radius;
+    CopyOnWrite<std::vector<sf::Color>> m_color;
+    CopyOnWrite<std::vector<uint8_t>> m_flags;
+    CopyOnWrite<std::vector<uint32_t>> m_community;
+    uint64_t m_version = 0;
+    uint64_t m_positionVersion = 0;
+
+    template <typename T>
+    static void swapRemove(std::vector<T>& column, uint32_t removed, uint32_t moved) {
+        column[removed] = column[moved];
+        column.pop_back();
+    }
+};
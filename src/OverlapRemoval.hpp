@@ -0,0 +1,210 @@
+#pragma once
+#include "SpatialGrid.hpp"
+#include "Trace.hpp"
+#include <SFML/System/Vector2.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <vector>
+
+struct OverlapRemovalOptions {
+    // Clear space kept between node circles.
+    float gap = 4.f;
+    int maxIterations = 200;
+};
+
+struct OverlapRemovalResult {
+    // Nodes that shared a position with another and were fanned out first.
+    size_t stacked = 0;
+    // Overlapping pairs once stacked nodes are fanned out, and at the end.
+    size_t overlapsBefore = 0;
+    size_t overlapsAfter = 0;
+    int iterations = 0;
+    // Clusters of overlapping nodes scaled up as a whole to make room.
+    size_t spreadGroups = 0;
+};
+
+// Removes overlaps between node circles after a layout, in the spirit of
+// PRISM: overlapping pairs are found through a uniform grid rather than a
+// Delaunay proximity graph, and each round moves both nodes of a pair
+// apart along the line between them, so the layout keeps its shape.
+//
+// Piled-up layouts get two extra steps. Nodes sharing one position are
+// found by sorting (O(n log n), once) and fanned out on a spiral, since no
+// direction separates them; and each round, clusters of overlapping nodes
+// too dense to fit are scaled up about their centre, which keeps the nodes
+// per grid cell bounded. A round costs O(n + overlaps) and at most
+// maxIterations rounds run, so a run is O(maxIterations * (n + overlaps))
+// with no better bound; crowded layouts can stop with overlaps left.
+class OverlapRemoval {
+public:
+    explicit OverlapRemoval(const OverlapRemovalOptions& options = {}) : m_options(options) {}
+
+    OverlapRemovalResult run(std::vector<sf::Vector2f>& positions, const std::vector<float>& radii) const {
+        TRACE_ZONE("OverlapRemoval::run");
+        OverlapRemovalResult result;
+        const size_t n = positions.size();
+        if (n < 2 || radii.size() != n) return result;
+
+        const float gap = m_options.gap;
+        const float maxRadius = *std::max_element(radii.begin(), radii.end());
+        const float cellSize = 2.f * maxRadius + gap;
+
+        result.stacked = separateDuplicates(positions, cellSize);
+        SpatialGrid grid;
+        std::vector<std::pair<uint32_t, uint32_t>> overlaps;
+        for (;; ++result.iterations) {
+            grid.build(positions, cellSize);
+            findOverlaps(grid, positions, radii, overlaps);
+            if (result.iterations == 0) result.overlapsBefore = overlaps.size();
+            if (overlaps.empty() || result.iterations == m_options.maxIterations) break;
+
+            result.spreadGroups += spreadCrowds(positions, radii, overlaps);
+
+            // One Gauss-Seidel sweep: each pair moves apart as soon as it
+            // is met, so later pairs see the corrected positions. The grid
+            // still holds the positions from the start of the round; pairs
+            // it misses are found in the next one.
+            for (size_t u = 0; u < n; ++u) {
+                grid.forEachNear(positions[u], radii[u] + maxRadius + gap, [&](uint32_t v) {
+                    if (v == u) return;
+                    float wanted = radii[u] + radii[v] + gap;
+                    sf::Vector2f delta = positions[u] - positions[v];
+                    float d2 = delta.x * delta.x + delta.y * delta.y;
+                    if (d2 >= (wanted - kTolerance) * (wanted - kTolerance)) return;
+                    float d = std::sqrt(d2);
+                    if (d < 1e-3f) {
+                        delta = u < v ? sf::Vector2f(-1.f, 0.f) : sf::Vector2f(1.f, 0.f);
+                        d = 1.f;
+                    }
+                    sf::Vector2f push = delta * (kRelaxation * 0.5f * (wanted - d) / d);
+                    positions[u] += push;
+                    positions[v] -= push;
+                });
+            }
+        }
+        result.overlapsAfter = overlaps.size();
+        return result;
+    }
+
+private:
+    // Pairs pushed to exactly the wanted spacing can land a rounding error
+    // short of it; they do not count as overlapping.
+    static constexpr float kTolerance = 1e-2f;
+    static constexpr size_t kMinCrowd = 16;
+    static constexpr double kCrowdSlack = 2.0;
+    // Over-relaxation: pushing pairs a little past the wanted spacing makes
+    // room faster in crowds than exact corrections, which mostly cancel.
+    static constexpr float kRelaxation = 1.8f;
+
+    OverlapRemovalOptions m_options;
+
+    void findOverlaps(const SpatialGrid& grid, const std::vector<sf::Vector2f>& positions,
+                      const std::vector<float>& radii, std::vector<std::pair<uint32_t, uint32_t>>& overlaps) const {
+        const float maxRadius = *std::max_element(radii.begin(), radii.end());
+        overlaps.clear();
+        for (uint32_t u = 0; u < positions.size(); ++u) {
+            grid.forEachNear(positions[u], radii[u] + maxRadius + m_options.gap, [&](uint32_t v) {
+                if (v <= u) return;
+                float wanted = radii[u] + radii[v] + m_options.gap - kTolerance;
+                sf::Vector2f delta = positions[u] - positions[v];
+                if (delta.x * delta.x + delta.y * delta.y < wanted * wanted) overlaps.emplace_back(u, v);
+            });
+        }
+    }
+
+    // Groups nodes into clusters of overlapping pairs and scales each
+    // cluster whose bounding box cannot hold its circles about its centre,
+    // so a crowd grows as a whole instead of one layer of pushes per round.
+    // Returns the number of clusters spread.
+    size_t spreadCrowds(std::vector<sf::Vector2f>& positions, const std::vector<float>& radii,
+                        const std::vector<std::pair<uint32_t, uint32_t>>& overlaps) const {
+        std::vector<uint32_t> parent(positions.size());
+        std::iota(parent.begin(), parent.end(), 0u);
+        auto find = [&](uint32_t u) {
+            while (parent[u] != u) u = parent[u] = parent[parent[u]];
+            return u;
+        };
+        for (const auto& pair : overlaps) {
+            uint32_t a = find(pair.first);
+            uint32_t b = find(pair.second);
+            if (a != b) parent[std::max(a, b)] = std::min(a, b);
+        }
+
+        struct Crowd {
+            sf::Vector2f min{std::numeric_limits<float>::max(), std::numeric_limits<float>::max()};
+            sf::Vector2f max{std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest()};
+            double needed = 0.0;
+            size_t size = 0;
+            float scale = 1.f;
+        };
+        std::vector<uint32_t> members;
+        for (const auto& pair : overlaps) {
+            members.push_back(pair.first);
+            members.push_back(pair.second);
+        }
+        std::sort(members.begin(), members.end());
+        members.erase(std::unique(members.begin(), members.end()), members.end());
+
+        std::vector<Crowd> crowds(positions.size());
+        for (uint32_t u : members) {
+            Crowd& crowd = crowds[find(u)];
+            const sf::Vector2f& p = positions[u];
+            crowd.min.x = std::min(crowd.min.x, p.x);
+            crowd.min.y = std::min(crowd.min.y, p.y);
+            crowd.max.x = std::max(crowd.max.x, p.x);
+            crowd.max.y = std::max(crowd.max.y, p.y);
+            double side = 2.0 * radii[u] + m_options.gap;
+            crowd.needed += side * side;
+            ++crowd.size;
+        }
+
+        // Scattered circles need about twice the area of a square packing
+        // before pushes settle them in a few rounds. Small clusters are left
+        // to the pushes, and the growth per round is capped so a spread
+        // cluster does not bury its neighbours.
+        size_t spread = 0;
+        for (uint32_t u : members) {
+            if (find(u) != u || crowds[u].size < kMinCrowd) continue;
+            Crowd& crowd = crowds[u];
+            double side = std::sqrt(crowd.needed / crowd.size);
+            double area = (crowd.max.x - crowd.min.x + side) * (crowd.max.y - crowd.min.y + side);
+            if (area >= kCrowdSlack * crowd.needed) continue;
+            crowd.scale = static_cast<float>(std::min(2.0, std::sqrt(kCrowdSlack * crowd.needed / area)));
+            ++spread;
+        }
+        for (uint32_t u : members) {
+            const Crowd& crowd = crowds[find(u)];
+            if (crowd.scale == 1.f) continue;
+            sf::Vector2f center = (crowd.min + crowd.max) / 2.f;
+            positions[u] = center + (positions[u] - center) * crowd.scale;
+        }
+        return spread;
+    }
+
+    static size_t separateDuplicates(std::vector<sf::Vector2f>& positions, float spacing) {
+        std::vector<uint32_t> order(positions.size());
+        std::iota(order.begin(), order.end(), 0u);
+        std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+            return positions[a].x < positions[b].x || (positions[a].x == positions[b].x && positions[a].y < positions[b].y);
+        });
+
+        const float goldenAngle = 2.39996323f;
+        size_t moved = 0;
+        for (size_t begin = 0; begin < order.size();) {
+            size_t end = begin + 1;
+            while (end < order.size() && positions[order[end]] == positions[order[begin]]) ++end;
+            sf::Vector2f center = positions[order[begin]];
+            for (size_t k = 1; k < end - begin; ++k) {
+                float radius = spacing * std::sqrt(static_cast<float>(k));
+                float angle = goldenAngle * k;
+                positions[order[begin + k]] = center + sf::Vector2f(radius * std::cos(angle), radius * std::sin(angle));
+            }
+            moved += end - begin - 1;
+            begin = end;
+        }
+        return moved;
+    }
+};
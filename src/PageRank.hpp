@@ -0,0 +1,87 @@
+#pragma once
+#include "Csr.hpp"
+#include "Parallel.hpp"
+#include <algorithm>
+#include <cmath>
+
+struct PageRankOptions {
+    double damping = 0.85;
+    double tolerance = 1e-6;
+    int maxIterations = 100;
+    int personalizeNode = -1;
+};
+
+struct PageRankResult {
+    std::vector<double> ranks;
+    int iterations = 0;
+    double residual = 0.0;
+    // False when maxIterations ran out before the residual met the tolerance.
+    bool converged = false;
+};
+
+// Power iteration over the pull formulation: each row of the CSC view gathers
+// rank from its in-neighbours, so rows can be updated by independent threads.
+// Stops once the L1 change between iterations drops below the tolerance.
+inline PageRankResult computePageRank(const CsrGraph& outgoing, const PageRankOptions& options = {}) {
+    PageRankResult result;
+    const size_t n = outgoing.nodeCount();
+    if (n == 0) return result;
+
+    const CsrGraph incoming = outgoing.transposed();
+
+    std::vector<double> teleport(n, 1.0 / n);
+    if (options.personalizeNode >= 0 && static_cast<size_t>(options.personalizeNode) < n) {
+        std::fill(teleport.begin(), teleport.end(), 0.0);
+        teleport[options.personalizeNode] = 1.0;
+    }
+
+    std::vector<double> rank = teleport;
+    std::vector<double> next(n, 0.0);
+    std::vector<double> contribution(n, 0.0);
+    std::vector<double> partialResidual(workerCount(), 0.0);
+    std::vector<double> partialDangling(workerCount(), 0.0);
+
+    for (result.iterations = 1; result.iterations <= options.maxIterations; ++result.iterations) {
+        std::fill(partialDangling.begin(), partialDangling.end(), 0.0);
+        parallelFor(n, [&](size_t begin, size_t end, unsigned worker) {
+            double dangling = 0.0;
+            for (size_t u = begin; u < end; ++u) {
+                uint32_t degree = outgoing.degree(static_cast<uint32_t>(u));
+                contribution[u] = degree ? rank[u] / degree : 0.0;
+                if (!degree) dangling += rank[u];
+            }
+            partialDangling[worker] = dangling;
+        });
+
+        double danglingMass = 0.0;
+        for (double d : partialDangling) danglingMass += d;
+
+        std::fill(partialResidual.begin(), partialResidual.end(), 0.0);
+        parallelFor(n, [&](size_t begin, size_t end, unsigned worker) {
+            double residual = 0.0;
+            for (size_t v = begin; v < end; ++v) {
+                double sum = 0.0;
+                for (const uint32_t* u = incoming.begin(static_cast<uint32_t>(v));
+                     u != incoming.end(static_cast<uint32_t>(v)); ++u) {
+                    sum += contribution[*u];
+                }
+                next[v] = options.damping * (sum + danglingMass * teleport[v]) +
+                          (1.0 - options.damping) * teleport[v];
+                residual += std::abs(next[v] - rank[v]);
+            }
+            partialResidual[worker] = residual;
+        });
+
+        rank.swap(next);
+        result.residual = 0.0;
+        for (double r : partialResidual) result.residual += r;
+        if (result.residual < options.tolerance) {
+            result.converged = true;
+            break;
+        }
+    }
+
+    result.iterations = std::min(result.iterations, options.maxIterations);
+    result.ranks = std::move(rank);
+    return result;
+}
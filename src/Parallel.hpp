@@ -0,0 +1,38 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+inline unsigned workerCount() {
+    unsigned hw = std::thread::hardware_concurrency();
+    return hw == 0 ? 1 : hw;
+}
+
+// Splits [0, count) into contiguous chunks, one per worker, and calls
+// fn(begin, end, worker) for each. Small ranges run on the calling thread.
+template <typename Fn>
+void parallelFor(size_t count, Fn&& fn, size_t minChunk = 1024) {
+    unsigned workers = static_cast<unsigned>(
+        std::min<size_t>(workerCount(), (count + minChunk - 1) / std::max<size_t>(minChunk, 1)));
+
+    if (workers <= 1) {
+        fn(size_t(0), count, 0u);
+        return;
+    }
+
+    size_t chunk = (count + workers - 1) / workers;
+    std::vector<std::thread> threads;
+    threads.reserve(workers - 1);
+
+    for (unsigned w = 1; w < workers; ++w) {
+        size_t begin = std::min(count, w * chunk);
+        size_t end = std::min(count, begin + chunk);
+        threads.emplace_back([&fn, begin, end, w]() { fn(begin, end, w); });
+    }
+    fn(size_t(0), std::min(count, chunk), 0u);
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
@@ -0,0 +1,226 @@
+#pragma once
+#include "Edge.hpp"
+#include "Memory.hpp"
+#include "Trace.hpp"
+#include <SFML/Graphics.hpp>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <string>
+
+// Where an edge's line and arrow heads go, shared by every output format.
+struct EdgeGeometry {
+    static constexpr float kArrowSize = 10.f;
+    static constexpr float kArrowGap = 15.f;
+
+    bool valid = false;
+    sf::Vector2f lineStart;
+    sf::Vector2f lineEnd;
+    // Arrow tips point along the direction and sit at base + direction * size.
+    bool hasArrow = false;
+    sf::Vector2f arrowBase;
+    sf::Vector2f arrowDirection;
+    bool hasReverseArrow = false;
+    sf::Vector2f reverseBase;
+    sf::Vector2f reverseDirection;
+
+    static EdgeGeometry compute(const NodeStore& nodes, const Edge& edge) {
+        EdgeGeometry geometry;
+        int64_t first = nodes.indexOf(edge.getFirst());
+        int64_t second = nodes.indexOf(edge.getSecond());
+        if (first < 0 || second < 0) return geometry;
+
+        sf::Vector2f startPos = nodes.getPosition(first);
+        sf::Vector2f endPos = nodes.getPosition(second);
+        float startRadius = nodes.getRadius(first);
+
+        sf::Vector2f direction = endPos - startPos;
+        float length = std::sqrt(direction.x * direction.x + direction.y * direction.y);
+        if (length <= 0) return geometry;
+        direction /= length;
+
+        geometry.valid = true;
+        geometry.lineStart = startPos + direction * startRadius;
+        geometry.lineEnd = endPos - direction * nodes.getRadius(second);
+        if (edge.isOriented()) {
+            geometry.lineEnd -= direction * kArrowGap;
+            geometry.hasArrow = true;
+            geometry.arrowBase = geometry.lineEnd;
+            geometry.arrowDirection = direction;
+            if (edge.isBidirectional()) {
+                geometry.hasReverseArrow = true;
+                geometry.reverseBase = startPos + direction * (startRadius + kArrowGap);
+                geometry.reverseDirection = -direction;
+            }
+        }
+        return geometry;
+    }
+
+    // The three corners of an arrow head, tip first.
+    static void arrowCorners(const sf::Vector2f& base, const sf::Vector2f& direction, sf::Vector2f corners[3]) {
+        sf::Vector2f normal(-direction.y, direction.x);
+        sf::Vector2f back = base - direction * kArrowSize;
+        corners[0] = base + direction * kArrowSize;
+        corners[1] = back + normal * kArrowSize;
+        corners[2] = back - normal * kArrowSize;
+    }
+};
+
+// Vertex batches for a set of nodes and edges: one textured quad per node
+// from the circle atlas, one quad per label glyph, a line list and an arrow
+// triangle list. A batch draws in four calls.
+struct RenderBatch {
+    sf::VertexArray lines{sf::Lines};
+    sf::VertexArray arrows{sf::Triangles};
+    sf::VertexArray circles{sf::Triangles};
+    sf::VertexArray labels{sf::Triangles};
+
+    void clear() {
+        lines.clear();
+        arrows.clear();
+        circles.clear();
+        labels.clear();
+    }
+
+    MemoryUsage memoryUsage() const {
+        MemoryUsage usage;
+        usage.bytes = vertexBytes(lines) + vertexBytes(arrows) + vertexBytes(circles) + vertexBytes(labels);
+        usage.objects = lines.getVertexCount() + arrows.getVertexCount() + circles.getVertexCount() +
+                        labels.getVertexCount();
+        return usage;
+    }
+};
+
+// Turns node columns and edge records into a RenderBatch. Labels are node
+// ids, so the metrics of the ten digit glyphs are copied out of the font up
+// front (setFont, main thread only: fetching a glyph may grow the font
+// texture). After that, building reads nothing but its arguments and can run
+// on any thread.
+class BatchBuilder {
+public:
+    static constexpr unsigned kLabelSize = 20;
+    static constexpr unsigned kAtlasCell = 128;
+    // Outline thickness relative to the radius, matching the old 1px / 2px
+    // outlines on 20px nodes.
+    static constexpr float kOutline = 1.f / 20.f;
+    static constexpr float kHighlightOutline = 2.f / 20.f;
+
+    static sf::Color edgeColor() { return sf::Color(235, 64, 52); }
+
+    void setFont(const sf::Font& font) {
+        if (m_font == &font) return;
+        m_font = &font;
+        for (char c = '0'; c <= '9'; ++c) {
+            m_digits[c - '0'] = font.getGlyph(static_cast<sf::Uint32>(c), kLabelSize, false);
+        }
+    }
+
+    // Everything except `excluded` and the edges touching it.
+    void build(RenderBatch& batch, const NodeStore& nodes, const SlotMap<Edge>& edges, bool drawEdges,
+               NodeHandle excluded) const {
+        TRACE_ZONE("BatchBuilder::build");
+        batch.clear();
+        if (drawEdges) {
+            for (const Edge& edge : edges) {
+                if (excluded && (edge.getFirst() == excluded || edge.getSecond() == excluded)) continue;
+                appendEdge(batch, nodes, edge);
+            }
+        }
+
+        int64_t skip = nodes.indexOf(excluded);
+        for (size_t i = 0; i < nodes.size(); ++i) {
+            if (static_cast<int64_t>(i) == skip) continue;
+            appendNode(batch, nodes, i);
+        }
+    }
+
+    static void appendEdge(RenderBatch& batch, const NodeStore& nodes, const Edge& edge) {
+        EdgeGeometry geometry = EdgeGeometry::compute(nodes, edge);
+        if (!geometry.valid) return;
+
+        if (geometry.hasArrow) appendArrow(batch, geometry.arrowBase, geometry.arrowDirection);
+        if (geometry.hasReverseArrow) appendArrow(batch, geometry.reverseBase, geometry.reverseDirection);
+        batch.lines.append(sf::Vertex(geometry.lineStart, edgeColor()));
+        batch.lines.append(sf::Vertex(geometry.lineEnd, edgeColor()));
+    }
+
+    void appendNode(RenderBatch& batch, const NodeStore& nodes, size_t i) const {
+        bool highlighted = nodes.isHighlighted(i);
+        float extent = nodes.getRadius(i) * (1.f + (highlighted ? kHighlightOutline : kOutline));
+        sf::Vector2f center = nodes.getPosition(i);
+        sf::Color color = nodes.getColor(i);
+        if (highlighted) color.a = 200;
+
+        appendQuad(batch.circles, sf::FloatRect(center.x - extent, center.y - extent, 2 * extent, 2 * extent),
+                   sf::FloatRect(highlighted ? float(kAtlasCell) : 0.f, 0.f, float(kAtlasCell), float(kAtlasCell)),
+                   color);
+        appendLabel(batch.labels, std::to_string(nodes.getId(i)), center);
+    }
+
+private:
+    const sf::Font* m_font = nullptr;
+    std::array<sf::Glyph, 10> m_digits{};
+
+    static void appendArrow(RenderBatch& batch, const sf::Vector2f& base, const sf::Vector2f& direction) {
+        sf::Vector2f corners[3];
+        EdgeGeometry::arrowCorners(base, direction, corners);
+        for (const auto& corner : corners) {
+            batch.arrows.append(sf::Vertex(corner, edgeColor()));
+        }
+    }
+
+    static void appendQuad(sf::VertexArray& array, const sf::FloatRect& rect, const sf::FloatRect& uv,
+                           const sf::Color& color) {
+        sf::Vertex topLeft(sf::Vector2f(rect.left, rect.top), color, sf::Vector2f(uv.left, uv.top));
+        sf::Vertex topRight(sf::Vector2f(rect.left + rect.width, rect.top), color,
+                            sf::Vector2f(uv.left + uv.width, uv.top));
+        sf::Vertex bottomRight(sf::Vector2f(rect.left + rect.width, rect.top + rect.height), color,
+                               sf::Vector2f(uv.left + uv.width, uv.top + uv.height));
+        sf::Vertex bottomLeft(sf::Vector2f(rect.left, rect.top + rect.height), color,
+                              sf::Vector2f(uv.left, uv.top + uv.height));
+        array.append(topLeft);
+        array.append(topRight);
+        array.append(bottomRight);
+        array.append(topLeft);
+        array.append(bottomRight);
+        array.append(bottomLeft);
+    }
+
+    // Lays the glyphs out on a baseline, then centres their combined bounds
+    // on the node like the old per-node sf::Text did.
+    void appendLabel(sf::VertexArray& labels, const std::string& text, const sf::Vector2f& center) const {
+        size_t first = labels.getVertexCount();
+        float pen = 0.f;
+        sf::FloatRect bounds;
+        bool any = false;
+
+        for (char c : text) {
+            if (c < '0' || c > '9') continue;
+            const sf::Glyph& glyph = m_digits[c - '0'];
+            sf::FloatRect rect(pen + glyph.bounds.left, glyph.bounds.top, glyph.bounds.width, glyph.bounds.height);
+            appendQuad(labels, rect,
+                       sf::FloatRect(float(glyph.textureRect.left), float(glyph.textureRect.top),
+                                     float(glyph.textureRect.width), float(glyph.textureRect.height)),
+                       sf::Color::Black);
+
+            if (!any) {
+                bounds = rect;
+                any = true;
+            } else {
+                float right = std::max(bounds.left + bounds.width, rect.left + rect.width);
+                float bottom = std::max(bounds.top + bounds.height, rect.top + rect.height);
+                bounds.left = std::min(bounds.left, rect.left);
+                bounds.top = std::min(bounds.top, rect.top);
+                bounds.width = right - bounds.left;
+                bounds.height = bottom - bounds.top;
+            }
+            pen += glyph.advance;
+        }
+
+        sf::Vector2f offset(center.x - (bounds.left + bounds.width / 2.f),
+                            center.y - (bounds.top + bounds.height / 2.f));
+        for (size_t v = first; v < labels.getVertexCount(); ++v) {
+            labels[v].position += offset;
+        }
+    }
+};
@@ -0,0 +1,47 @@
+#pragma once
+#include <SFML/Window.hpp>
+#include <chrono>
+#include <cstdint>
+
+// Decides when the window needs a new frame. A frame is drawn when the
+// graph's frame version moved, when background geometry became ready, or
+// when something outside the graph invalidated the window (resize, focus).
+// With nothing to draw and nothing animating, the loop may block in
+// waitEvent instead of spinning at the frame rate. A minimum interval
+// caps the frame rate further, so a graph that changes continuously (an
+// edge stream) spends its time on the changes rather than on drawing them.
+class RenderScheduler {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    void invalidate() { m_forced = true; }
+
+    void setMinInterval(Clock::duration interval) { m_minInterval = interval; }
+
+    bool isThrottled() const { return Clock::now() - m_drawnAt < m_minInterval; }
+
+    // Window events that change the picture without touching the graph.
+    void observe(const sf::Event& event) {
+        if (event.type == sf::Event::Resized || event.type == sf::Event::GainedFocus) invalidate();
+    }
+
+    bool shouldDraw(uint64_t version, bool newFrame) const {
+        return (m_forced || newFrame || version != m_drawnVersion) && !isThrottled();
+    }
+
+    void markDrawn(uint64_t version) {
+        m_drawnVersion = version;
+        m_forced = false;
+        m_drawnAt = Clock::now();
+    }
+
+    bool canWait(uint64_t version, bool animating) const {
+        return !animating && !m_forced && version == m_drawnVersion;
+    }
+
+private:
+    uint64_t m_drawnVersion = 0;
+    bool m_forced = true;
+    Clock::duration m_minInterval = Clock::duration::zero();
+    Clock::time_point m_drawnAt;
+};
@@ -0,0 +1,153 @@
+#pragma once
+#include "RenderBatch.hpp"
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+// Builds batches on a background thread so big rebuilds never hold up event
+// handling or display. There are two batches: the main thread draws the
+// front one while the worker fills the back one from a copy of the scene,
+// and they trade places at a frame boundary (swapBuffers) once the back one
+// is complete. The copy is O(1): node and edge storage is copy-on-write, so
+// the main thread only clones the columns it changes while the worker
+// still holds them. Submissions made while a build is running coalesce; only the
+// latest is built next.
+class RenderWorker {
+public:
+    ~RenderWorker() { stop(); }
+
+    // Takes a copy-on-write snapshot of what the build reads, so the caller
+    // may mutate right after.
+    void submit(const BatchBuilder& builder, const NodeStore& nodes, const SlotMap<Edge>& edges, bool drawEdges,
+                uint64_t version, NodeHandle excluded) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_thread.joinable()) m_thread = std::thread([this]() { run(); });
+        m_pending.builder = builder;
+        m_pending.nodes = nodes;
+        m_pending.edges = edges;
+        m_pending.drawEdges = drawEdges;
+        m_pending.version = version;
+        m_pending.excluded = excluded;
+        m_hasPending = true;
+        m_wake.notify_all();
+    }
+
+    // Promotes a finished back batch to the front. Returns whether it did.
+    bool swapBuffers() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return swapLocked();
+    }
+
+    // Blocks until every submission so far is built and in front.
+    bool finish() {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        bool swapped = false;
+        while (true) {
+            swapped |= swapLocked();
+            if (!m_hasPending && !m_building) return swapped;
+            m_done.wait(lock);
+        }
+    }
+
+    // Whether a submission is queued, being built, or built but not swapped in.
+    bool isBusy() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_hasPending || m_building || m_backReady;
+    }
+
+    bool hasBackReady() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_backReady;
+    }
+
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopping = true;
+            m_wake.notify_all();
+        }
+        if (m_thread.joinable()) m_thread.join();
+    }
+
+    // Both batches; the back one is left out while it is being built. Scene
+    // snapshots share their storage with the graph and are not counted.
+    MemoryUsage memoryUsage() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        MemoryUsage usage = m_batches[m_front].memoryUsage();
+        if (!m_building) usage += m_batches[m_front ^ 1].memoryUsage();
+        return usage;
+    }
+
+    // Only valid on the main thread, between swaps.
+    const RenderBatch& front() const { return m_batches[m_front]; }
+    bool hasFront() const { return m_frontVersion != UINT64_MAX; }
+    uint64_t frontVersion() const { return m_frontVersion; }
+    NodeHandle frontExcludes() const { return m_frontExcludes; }
+
+private:
+    struct Snapshot {
+        BatchBuilder builder;
+        NodeStore nodes;
+        SlotMap<Edge> edges;
+        bool drawEdges = true;
+        uint64_t version = 0;
+        NodeHandle excluded;
+    };
+
+    std::thread m_thread;
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_done;
+    bool m_stopping = false;
+
+    Snapshot m_pending;
+    bool m_hasPending = false;
+    Snapshot m_work;
+    bool m_building = false;
+
+    RenderBatch m_batches[2];
+    unsigned m_front = 0;
+    uint64_t m_frontVersion = UINT64_MAX;
+    NodeHandle m_frontExcludes;
+    bool m_backReady = false;
+    uint64_t m_backVersion = 0;
+    NodeHandle m_backExcludes;
+
+    bool swapLocked() {
+        if (!m_backReady) return false;
+        m_front ^= 1;
+        m_frontVersion = m_backVersion;
+        m_frontExcludes = m_backExcludes;
+        m_backReady = false;
+        m_wake.notify_all();
+        return true;
+    }
+
+    void run() {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while (true) {
+            // The back batch is off limits until the main thread has taken it.
+            m_wake.wait(lock, [this]() { return m_stopping || (m_hasPending && !m_backReady); });
+            if (m_stopping) return;
+
+            std::swap(m_work, m_pending);
+            m_hasPending = false;
+            m_building = true;
+            RenderBatch& back = m_batches[m_front ^ 1];
+            lock.unlock();
+
+            m_work.builder.build(back, m_work.nodes, m_work.edges, m_work.drawEdges, m_work.excluded);
+            // Let go of the snapshot so the main thread's next writes need
+            // not clone anything.
+            m_work.nodes = NodeStore();
+            m_work.edges = SlotMap<Edge>();
+
+            lock.lock();
+            m_backVersion = m_work.version;
+            m_backExcludes = m_work.excluded;
+            m_backReady = true;
+            m_building = false;
+            m_done.notify_all();
+        }
+    }
+};
@@ -0,0 +1,191 @@
+#pragma once
+#include "KeyIndex.hpp"
+#include <SFML/System/Vector2.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+// Line segments keyed by slot (a handle's index), for picking the segment
+// nearest a point; a box can be stored as its diagonal and found with
+// forEachNear. Segments live in a hierarchy of hashed grids: level L
+// has cells of kCellSize * 2^L, and a segment is stored once, in the cell
+// of the first level whose cells are at least as large as its bounding
+// box, so its box lies within that cell and the next ones right and down.
+// Long and short segments never crowd the same cells, insert, remove and
+// move are O(1), and a query looks at a 2x2 or 3x3 block of cells per
+// occupied level.
+class SegmentIndex {
+public:
+    static constexpr float kCellSize = 8.f;
+    static constexpr uint32_t kMissing = UINT32_MAX;
+
+    // Stores or moves the segment of a slot; value is returned by nearest.
+    void insert(uint32_t slot, uint32_t value, const sf::Vector2f& a, const sf::Vector2f& b) {
+        if (slot >= m_entries.size()) m_entries.resize(std::max<size_t>(slot + 1, m_entries.size() * 3 / 2));
+        Entry& entry = m_entries[slot];
+        uint64_t cell = cellOf(a, b);
+        if (entry.value != kMissing && entry.cell != cell) detach(slot);
+        if (entry.value == kMissing || entry.cell != cell) attach(slot, cell);
+        entry.value = value;
+        entry.a = a;
+        entry.b = b;
+    }
+
+    bool remove(uint32_t slot) {
+        if (slot >= m_entries.size() || m_entries[slot].value == kMissing) return false;
+        detach(slot);
+        m_entries[slot].value = kMissing;
+        return true;
+    }
+
+    void clear() {
+        m_entries.clear();
+        m_cells.clear();
+        m_buckets.clear();
+        m_freeBuckets.clear();
+        std::fill(std::begin(m_levelCounts), std::end(m_levelCounts), 0);
+        m_size = 0;
+    }
+
+    void reserve(size_t slots) {
+        m_entries.reserve(slots);
+        m_cells.reserve(slots);
+        m_buckets.reserve(slots);
+    }
+
+    // The value of the segment nearest point within tolerance, or kMissing.
+    uint32_t nearest(const sf::Vector2f& point, float tolerance) const {
+        uint32_t best = kMissing;
+        float bestDistance = tolerance * tolerance;
+        forEachNear(point, tolerance, [&](uint32_t value, const sf::Vector2f& a, const sf::Vector2f& b) {
+            float distance = distanceSquared(point, a, b);
+            if (distance <= bestDistance) {
+                bestDistance = distance;
+                best = value;
+            }
+        });
+        return best;
+    }
+
+    // Calls fn(value, a, b) for at least every segment whose bounding box
+    // comes within tolerance of point.
+    template <typename Fn>
+    void forEachNear(const sf::Vector2f& point, float tolerance, Fn&& fn) const {
+        for (int level = 0; level < kLevels; ++level) {
+            if (m_levelCounts[level] == 0) continue;
+            float size = cellSize(level);
+            int64_t x0 = cellCoordinate(point.x - tolerance - size, size);
+            int64_t y0 = cellCoordinate(point.y - tolerance - size, size);
+            int64_t x1 = cellCoordinate(point.x + tolerance, size);
+            int64_t y1 = cellCoordinate(point.y + tolerance, size);
+            for (int64_t y = y0; y <= y1; ++y) {
+                for (int64_t x = x0; x <= x1; ++x) {
+                    uint32_t bucket = m_cells.find(cellKey(level, x, y));
+                    if (bucket == KeyIndex::kMissing) continue;
+                    for (uint32_t slot : m_buckets[bucket]) {
+                        const Entry& entry = m_entries[slot];
+                        fn(entry.value, entry.a, entry.b);
+                    }
+                }
+            }
+        }
+    }
+
+    size_t size() const { return m_size; }
+
+    size_t memoryBytes() const {
+        size_t bytes = m_entries.capacity() * sizeof(Entry) + m_cells.memoryBytes() +
+                       m_buckets.capacity() * sizeof(std::vector<uint32_t>) + m_freeBuckets.capacity() * sizeof(uint32_t);
+        for (const auto& bucket : m_buckets) bytes += bucket.capacity() * sizeof(uint32_t);
+        return bytes;
+    }
+
+    static float distanceSquared(const sf::Vector2f& p, const sf::Vector2f& a, const sf::Vector2f& b) {
+        sf::Vector2f ab = b - a;
+        sf::Vector2f ap = p - a;
+        float length = ab.x * ab.x + ab.y * ab.y;
+        float t = length > 0.f ? std::min(std::max((ap.x * ab.x + ap.y * ab.y) / length, 0.f), 1.f) : 0.f;
+        sf::Vector2f d = ap - ab * t;
+        return d.x * d.x + d.y * d.y;
+    }
+
+private:
+    // Cell sizes from 8 px up to 2^29 px; coordinates are clamped to the
+    // 28-bit range the cell keys have room for.
+    static constexpr int kLevels = 27;
+    static constexpr int64_t kCoordinateLimit = (int64_t(1) << 27) - 1;
+
+    struct Entry {
+        uint32_t value = kMissing;
+        // Position in its bucket, for O(1) removal.
+        uint32_t position = 0;
+        uint64_t cell = 0;
+        sf::Vector2f a;
+        sf::Vector2f b;
+    };
+
+    std::vector<Entry> m_entries;
+    // Cell key to bucket; buckets of emptied cells are reused.
+    KeyIndex m_cells;
+    std::vector<std::vector<uint32_t>> m_buckets;
+    std::vector<uint32_t> m_freeBuckets;
+    size_t m_levelCounts[kLevels] = {};
+    size_t m_size = 0;
+
+    static float cellSize(int level) { return std::ldexp(kCellSize, level); }
+
+    static int64_t cellCoordinate(float value, float size) {
+        double cell = std::floor(static_cast<double>(value) / size);
+        if (std::isnan(cell)) return 0;
+        return static_cast<int64_t>(std::min<double>(std::max<double>(cell, -kCoordinateLimit), kCoordinateLimit));
+    }
+
+    static uint64_t cellKey(int level, int64_t x, int64_t y) {
+        return (static_cast<uint64_t>(level) << 56) | (static_cast<uint64_t>(x + kCoordinateLimit) << 28) |
+               static_cast<uint64_t>(y + kCoordinateLimit);
+    }
+
+    static uint64_t cellOf(const sf::Vector2f& a, const sf::Vector2f& b) {
+        float extent = std::max(std::abs(b.x - a.x), std::abs(b.y - a.y));
+        int level = 0;
+        while (level < kLevels - 1 && cellSize(level) < extent) ++level;
+        float size = cellSize(level);
+        return cellKey(level, cellCoordinate(std::min(a.x, b.x), size), cellCoordinate(std::min(a.y, b.y), size));
+    }
+
+    void attach(uint32_t slot, uint64_t cell) {
+        uint32_t bucket = m_cells.find(cell);
+        if (bucket == KeyIndex::kMissing) {
+            if (m_freeBuckets.empty()) {
+                bucket = static_cast<uint32_t>(m_buckets.size());
+                m_buckets.emplace_back();
+            } else {
+                bucket = m_freeBuckets.back();
+                m_freeBuckets.pop_back();
+            }
+            m_cells.insert(cell, bucket);
+        }
+        Entry& entry = m_entries[slot];
+        entry.cell = cell;
+        entry.position = static_cast<uint32_t>(m_buckets[bucket].size());
+        m_buckets[bucket].push_back(slot);
+        ++m_levelCounts[cell >> 56];
+        ++m_size;
+    }
+
+    void detach(uint32_t slot) {
+        const Entry& entry = m_entries[slot];
+        uint32_t bucket = m_cells.find(entry.cell);
+        std::vector<uint32_t>& items = m_buckets[bucket];
+        items[entry.position] = items.back();
+        m_entries[items.back()].position = entry.position;
+        items.pop_back();
+        if (items.empty()) {
+            m_cells.erase(entry.cell);
+            m_freeBuckets.push_back(bucket);
+        }
+        --m_levelCounts[entry.cell >> 56];
+        --m_size;
+    }
+};
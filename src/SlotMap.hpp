@@ -0,0 +1,215 @@
+#pragma once
+#include "CopyOnWrite.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+// 32-bit generational handle: the low 24 bits index a slot, the high 8 bits
+// hold the slot's generation when the handle was issued. A handle to a
+// removed element does not resolve again when its slot is reused, until the
+// slot's generation wraps after 256 reuses. Slots are never retired, so
+// churn does not leak them; a handle kept across that many reuses of its
+// slot could alias a newer element, and that risk is accepted.
+template <typename Tag>
+struct Handle {
+    static constexpr uint32_t kIndexBits = 24;
+    static constexpr uint32_t kIndexMask = (1u << kIndexBits) - 1;
+    static constexpr uint32_t kMaxGeneration = (1u << (32 - kIndexBits)) - 1;
+    // Live elements per store; the all-ones index is left out so no handle
+    // equals the invalid value.
+    static constexpr size_t kMaxSlots = kIndexMask;
+
+    uint32_t value = UINT32_MAX;
+
+    Handle() = default;
+    Handle(uint32_t index, uint32_t generation) : value((generation << kIndexBits) | index) {}
+
+    uint32_t index() const { return value & kIndexMask; }
+    uint32_t generation() const { return value >> kIndexBits; }
+    bool isValid() const { return value != UINT32_MAX; }
+    explicit operator bool() const { return isValid(); }
+
+    bool operator==(const Handle& other) const { return value == other.value; }
+    bool operator!=(const Handle& other) const { return value != other.value; }
+    bool operator<(const Handle& other) const { return value < other.value; }
+};
+
+// Handle bookkeeping for densely packed storage. Elements live at
+// [0, size()) in whatever arrays the owner keeps; allocate() appends one and
+// release() tells the owner which element to swap into the hole, so both are
+// O(1) and iteration stays linear.
+template <typename Tag>
+class SlotIndex {
+public:
+    using HandleType = Handle<Tag>;
+
+    struct Release {
+        uint32_t removed;
+        // Dense index of the element that must be moved into `removed`; equal
+        // to `removed` when the last element was released.
+        uint32_t moved;
+    };
+
+    size_t size() const { return m_denseToSlot.size(); }
+
+    HandleType allocate() {
+        uint32_t dense = static_cast<uint32_t>(m_denseToSlot.size());
+        uint32_t slot;
+        if (m_freeHead != kNone) {
+            slot = m_freeHead;
+            m_freeHead = m_slots[slot].dense;
+        } else {
+            // Slot indices past the mask would spill into the generation
+            // bits and make handles alias. Slots are only added for live
+            // elements, so this takes kMaxSlots elements at once; loaders
+            // refuse graphs that large up front.
+            if (m_slots.size() >= HandleType::kMaxSlots) throw std::length_error("SlotIndex: out of handle slots");
+            slot = static_cast<uint32_t>(m_slots.size());
+            m_slots.push_back({0, 0});
+        }
+        m_slots[slot].dense = dense;
+        m_denseToSlot.push_back(slot);
+        return HandleType(slot, m_slots[slot].generation);
+    }
+
+    bool contains(HandleType handle) const {
+        return handle.isValid() && handle.index() < m_slots.size() &&
+               m_slots[handle.index()].generation == handle.generation() &&
+               m_slots[handle.index()].dense != kNone &&
+               m_slots[handle.index()].dense < m_denseToSlot.size() &&
+               m_denseToSlot[m_slots[handle.index()].dense] == handle.index();
+    }
+
+    // Dense index of a live handle, or -1.
+    int64_t indexOf(HandleType handle) const {
+        return contains(handle) ? static_cast<int64_t>(m_slots[handle.index()].dense) : -1;
+    }
+
+    HandleType handleAt(size_t dense) const {
+        uint32_t slot = m_denseToSlot[dense];
+        return HandleType(slot, m_slots[slot].generation);
+    }
+
+    // The caller must have checked contains(handle).
+    Release release(HandleType handle) {
+        uint32_t slot = handle.index();
+        uint32_t removed = m_slots[slot].dense;
+        uint32_t last = static_cast<uint32_t>(m_denseToSlot.size() - 1);
+
+        uint32_t movedSlot = m_denseToSlot[last];
+        m_denseToSlot[removed] = movedSlot;
+        m_slots[movedSlot].dense = removed;
+        m_denseToSlot.pop_back();
+
+        m_slots[slot].generation = (m_slots[slot].generation + 1) & HandleType::kMaxGeneration;
+        m_slots[slot].dense = m_freeHead;
+        m_freeHead = slot;
+        return {removed, last};
+    }
+
+    // Drops every element in O(slots). Every slot moves on a generation, so
+    // old handles stop resolving as with release, and the free list hands
+    // slots out from index 0 again.
+    void clear() {
+        m_denseToSlot.clear();
+        m_freeHead = kNone;
+        for (uint32_t slot = static_cast<uint32_t>(m_slots.size()); slot-- > 0;) {
+            m_slots[slot].generation = (m_slots[slot].generation + 1) & HandleType::kMaxGeneration;
+            m_slots[slot].dense = m_freeHead;
+            m_freeHead = slot;
+        }
+    }
+
+    void reserve(size_t count) {
+        m_slots.reserve(count);
+        m_denseToSlot.reserve(count);
+    }
+
+    size_t memoryBytes() const {
+        return m_slots.capacity() * sizeof(Slot) + m_denseToSlot.capacity() * sizeof(uint32_t);
+    }
+
+private:
+    static constexpr uint32_t kNone = UINT32_MAX;
+
+    struct Slot {
+        // Dense index while live, next free slot while on the free list.
+        uint32_t dense;
+        uint32_t generation;
+    };
+
+    std::vector<Slot> m_slots;
+    std::vector<uint32_t> m_denseToSlot;
+    uint32_t m_freeHead = kNone;
+};
+
+// Contiguous storage addressed by generational handles. Copies share the
+// values and the index until either side writes, so a copy is O(1); the
+// non-const accessors count as writes.
+template <typename T, typename Tag = T>
+class SlotMap {
+public:
+    using HandleType = Handle<Tag>;
+
+    HandleType insert(T value) {
+        m_values.write().push_back(std::move(value));
+        return m_index.write().allocate();
+    }
+
+    bool remove(HandleType handle) {
+        if (!m_index.read().contains(handle)) return false;
+        auto release = m_index.write().release(handle);
+        std::vector<T>& values = m_values.write();
+        if (release.moved != release.removed) {
+            values[release.removed] = std::move(values[release.moved]);
+        }
+        values.pop_back();
+        return true;
+    }
+
+    bool contains(HandleType handle) const { return m_index.read().contains(handle); }
+    int64_t indexOf(HandleType handle) const { return m_index.read().indexOf(handle); }
+    HandleType handleAt(size_t dense) const { return m_index.read().handleAt(dense); }
+
+    T* get(HandleType handle) {
+        int64_t dense = m_index.read().indexOf(handle);
+        return dense < 0 ? nullptr : &m_values.write()[dense];
+    }
+    const T* get(HandleType handle) const {
+        int64_t dense = m_index.read().indexOf(handle);
+        return dense < 0 ? nullptr : &m_values.read()[dense];
+    }
+
+    T& operator[](size_t dense) { return m_values.write()[dense]; }
+    const T& operator[](size_t dense) const { return m_values.read()[dense]; }
+
+    size_t size() const { return m_values.read().size(); }
+    bool empty() const { return m_values.read().empty(); }
+
+    // Keeps the slots, so handles to the old values stay stale.
+    void clear() {
+        m_values.reset();
+        m_index.write().clear();
+    }
+
+    void reserve(size_t count) {
+        m_values.write().reserve(count);
+        m_index.write().reserve(count);
+    }
+
+    // Heap held by the values and the handle index; not what the values
+    // themselves may own.
+    size_t memoryBytes() const {
+        return m_values.read().capacity() * sizeof(T) + m_index.read().memoryBytes();
+    }
+
+    typename std::vector<T>::iterator begin() { return m_values.write().begin(); }
+    typename std::vector<T>::iterator end() { return m_values.write().end(); }
+    typename std::vector<T>::const_iterator begin() const { return m_values.read().begin(); }
+    typename std::vector<T>::const_iterator end() const { return m_values.read().end(); }
+
+private:
+    CopyOnWrite<std::vector<T>> m_values;
+    CopyOnWrite<SlotIndex<Tag>> m_index;
+};
@@ -0,0 +1,87 @@
+#pragma once
+#include <SFML/System/Vector2.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+// Uniform bucket grid over a fixed set of points, stored as a counting-sorted
+// index array so lookups touch only contiguous memory.
+class SpatialGrid {
+public:
+    void build(const std::vector<sf::Vector2f>& points, float cellSize) {
+        m_cellSize = std::max(cellSize, 1e-3f);
+        m_items.clear();
+        m_cellStart.assign(1, 0);
+        if (points.empty()) return;
+
+        m_min = points.front();
+        sf::Vector2f max = points.front();
+        for (const auto& p : points) {
+            m_min.x = std::min(m_min.x, p.x);
+            m_min.y = std::min(m_min.y, p.y);
+            max.x = std::max(max.x, p.x);
+            max.y = std::max(max.y, p.y);
+        }
+
+        // Keep the cell count proportional to the number of points so sparse
+        // outliers cannot blow up memory.
+        for (;;) {
+            m_columns = static_cast<int>((max.x - m_min.x) / m_cellSize) + 1;
+            m_rows = static_cast<int>((max.y - m_min.y) / m_cellSize) + 1;
+            if (static_cast<double>(m_columns) * m_rows <= 4.0 * points.size() + 16) break;
+            m_cellSize *= 2.f;
+        }
+
+        m_cellStart.assign(static_cast<size_t>(m_columns) * m_rows + 1, 0);
+        std::vector<uint32_t> cellOf(points.size());
+        for (size_t i = 0; i < points.size(); ++i) {
+            cellOf[i] = cellIndex(points[i]);
+            ++m_cellStart[cellOf[i] + 1];
+        }
+        for (size_t c = 1; c < m_cellStart.size(); ++c) {
+            m_cellStart[c] += m_cellStart[c - 1];
+        }
+
+        m_items.resize(points.size());
+        std::vector<uint32_t> cursor(m_cellStart.begin(), m_cellStart.end() - 1);
+        for (size_t i = 0; i < points.size(); ++i) {
+            m_items[cursor[cellOf[i]]++] = static_cast<uint32_t>(i);
+        }
+    }
+
+    // Calls fn(index) for every point in the cells overlapping the square of
+    // half-size radius around center; callers do the exact distance test.
+    template <typename Fn>
+    void forEachNear(const sf::Vector2f& center, float radius, Fn&& fn) const {
+        if (m_items.empty()) return;
+
+        int x0 = std::max(0, static_cast<int>(std::floor((center.x - radius - m_min.x) / m_cellSize)));
+        int y0 = std::max(0, static_cast<int>(std::floor((center.y - radius - m_min.y) / m_cellSize)));
+        int x1 = std::min(m_columns - 1, static_cast<int>(std::floor((center.x + radius - m_min.x) / m_cellSize)));
+        int y1 = std::min(m_rows - 1, static_cast<int>(std::floor((center.y + radius - m_min.y) / m_cellSize)));
+
+        for (int y = y0; y <= y1; ++y) {
+            for (int x = x0; x <= x1; ++x) {
+                size_t cell = static_cast<size_t>(y) * m_columns + x;
+                for (uint32_t i = m_cellStart[cell]; i < m_cellStart[cell + 1]; ++i) {
+                    fn(m_items[i]);
+                }
+            }
+        }
+    }
+
+private:
+    float m_cellSize = 1.f;
+    sf::Vector2f m_min;
+    int m_columns = 0;
+    int m_rows = 0;
+    std::vector<uint32_t> m_cellStart;
+    std::vector<uint32_t> m_items;
+
+    uint32_t cellIndex(const sf::Vector2f& p) const {
+        int x = std::min(m_columns - 1, static_cast<int>((p.x - m_min.x) / m_cellSize));
+        int y = std::min(m_rows - 1, static_cast<int>((p.y - m_min.y) / m_cellSize));
+        return static_cast<uint32_t>(y * m_columns + x);
+    }
+};
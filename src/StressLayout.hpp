@@ -0,0 +1,244 @@
+#pragma once
+#include "Bfs.hpp"
+#include "Parallel.hpp"
+#include "Trace.hpp"
+#include <SFML/System/Vector2.hpp>
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <mutex>
+#include <numeric>
+#include <thread>
+
+// Hop distances from k pivots spread by max-min selection; row p holds the
+// distances from pivots[p] to every node. Unreachable nodes get one more than
+// the largest finite distance so disconnected parts stay nearby.
+struct PivotDistances {
+    std::vector<uint32_t> pivots;
+    std::vector<std::vector<float>> rows;
+
+    static PivotDistances compute(const CsrGraph& graph, size_t pivotCount) {
+        PivotDistances result;
+        const size_t n = graph.nodeCount();
+        pivotCount = std::min(pivotCount, n);
+        if (pivotCount == 0) return result;
+
+        std::vector<int32_t> nearest(n, INT32_MAX);
+        BfsWorkspace bfs;
+        uint32_t pivot = 0;
+        for (size_t p = 0; p < pivotCount; ++p) {
+            result.pivots.push_back(pivot);
+            bfs.run(graph, pivot);
+
+            int32_t farthest = 0;
+            for (int32_t d : bfs.distance) farthest = std::max(farthest, d);
+            std::vector<float> row(n);
+            for (size_t v = 0; v < n; ++v) {
+                int32_t d = bfs.distance[v] < 0 ? farthest + 1 : bfs.distance[v];
+                row[v] = static_cast<float>(d);
+                nearest[v] = std::min(nearest[v], d);
+            }
+            result.rows.push_back(std::move(row));
+            pivot = static_cast<uint32_t>(std::max_element(nearest.begin(), nearest.end()) - nearest.begin());
+        }
+        return result;
+    }
+};
+
+// Pivot MDS (Brandes & Pich): double-centre the squared n x k distance matrix
+// C, take the two leading eigenvectors of the k x k matrix C^T C by power
+// iteration, and project every node with C in linear time. The result is
+// scaled so that one hop maps to edgeLength.
+inline std::vector<sf::Vector2f> pivotMds(const PivotDistances& distances, size_t n, float edgeLength) {
+    const size_t k = distances.pivots.size();
+    std::vector<sf::Vector2f> positions(n);
+    if (k < 2 || n == 0) return positions;
+
+    std::vector<double> c(n * k);
+    std::vector<double> columnMean(k, 0.0);
+    std::vector<double> rowMean(n, 0.0);
+    double grandMean = 0.0;
+    for (size_t p = 0; p < k; ++p) {
+        for (size_t v = 0; v < n; ++v) {
+            double d2 = double(distances.rows[p][v]) * distances.rows[p][v];
+            c[v * k + p] = d2;
+            columnMean[p] += d2 / n;
+            rowMean[v] += d2 / k;
+            grandMean += d2 / (double(n) * k);
+        }
+    }
+    parallelFor(n, [&](size_t begin, size_t end, unsigned) {
+        for (size_t v = begin; v < end; ++v) {
+            for (size_t p = 0; p < k; ++p) {
+                c[v * k + p] = -0.5 * (c[v * k + p] - rowMean[v] - columnMean[p] + grandMean);
+            }
+        }
+    });
+
+    std::vector<double> b(k * k, 0.0);
+    for (size_t v = 0; v < n; ++v) {
+        const double* row = &c[v * k];
+        for (size_t i = 0; i < k; ++i) {
+            for (size_t j = 0; j < k; ++j) {
+                b[i * k + j] += row[i] * row[j];
+            }
+        }
+    }
+
+    std::vector<std::vector<double>> eigen;
+    for (int axis = 0; axis < 2; ++axis) {
+        std::vector<double> vec(k);
+        for (size_t i = 0; i < k; ++i) vec[i] = 1.0 + (i % (axis + 2));
+        std::vector<double> next(k);
+        for (int iteration = 0; iteration < 200; ++iteration) {
+            for (const auto& previous : eigen) {
+                double dot = std::inner_product(vec.begin(), vec.end(), previous.begin(), 0.0);
+                for (size_t i = 0; i < k; ++i) vec[i] -= dot * previous[i];
+            }
+            for (size_t i = 0; i < k; ++i) {
+                next[i] = std::inner_product(b.begin() + i * k, b.begin() + (i + 1) * k, vec.begin(), 0.0);
+            }
+            double norm = std::sqrt(std::inner_product(next.begin(), next.end(), next.begin(), 0.0));
+            if (norm <= 0.0) break;
+            for (double& x : next) x /= norm;
+            vec.swap(next);
+        }
+        eigen.push_back(vec);
+    }
+
+    parallelFor(n, [&](size_t begin, size_t end, unsigned) {
+        for (size_t v = begin; v < end; ++v) {
+            const double* row = &c[v * k];
+            positions[v].x = static_cast<float>(std::inner_product(row, row + k, eigen[0].begin(), 0.0));
+            positions[v].y = static_cast<float>(std::inner_product(row, row + k, eigen[1].begin(), 0.0));
+        }
+    });
+
+    // Least-squares scale against the pivot distances.
+    double numerator = 0.0, denominator = 0.0;
+    for (size_t p = 0; p < k; ++p) {
+        sf::Vector2f pivot = positions[distances.pivots[p]];
+        for (size_t v = 0; v < n; ++v) {
+            sf::Vector2f delta = positions[v] - pivot;
+            double length = std::sqrt(delta.x * delta.x + delta.y * delta.y);
+            numerator += distances.rows[p][v] * length;
+            denominator += length * length;
+        }
+    }
+    float scale = denominator > 0.0 ? static_cast<float>(edgeLength * numerator / denominator) : edgeLength;
+    for (auto& p : positions) p *= scale;
+    return positions;
+}
+
+// Sparse stress majorisation (Ortmann et al.) on a background thread: each
+// node is pulled towards its graph neighbours and the pivots at their target
+// distances. Every iteration publishes a snapshot that the UI thread picks up
+// with takePositions().
+class StressRefiner {
+public:
+    ~StressRefiner() { stop(); }
+
+    void start(const CsrGraph& graph, PivotDistances distances, std::vector<sf::Vector2f> initial,
+               float edgeLength, int maxIterations = 200) {
+        stop();
+        m_positions = initial;
+        m_version = 0;
+        m_taken = 0;
+        m_running = true;
+        m_thread = std::thread([this, graph, distances = std::move(distances),
+                                initial = std::move(initial), edgeLength, maxIterations]() mutable {
+            TRACE_ZONE("StressRefiner::refine");
+            refine(graph, distances, std::move(initial), edgeLength, maxIterations);
+        });
+    }
+
+    // Ends the refinement and drops any snapshot not yet taken, so nothing
+    // it streamed lands after an edit or during a drag.
+    void stop() {
+        m_running = false;
+        if (m_thread.joinable()) m_thread.join();
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_taken = m_version;
+    }
+
+    // Lets the refinement run to convergence.
+    void wait() {
+        if (m_thread.joinable()) m_thread.join();
+    }
+
+    bool isRunning() const { return m_running; }
+
+    // Whether a snapshot is waiting for takePositions.
+    bool hasPositions() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_version != m_taken;
+    }
+
+    bool takePositions(std::vector<sf::Vector2f>& out) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_version == m_taken) return false;
+        m_taken = m_version;
+        out = m_positions;
+        return true;
+    }
+
+private:
+    std::thread m_thread;
+    std::atomic<bool> m_running{false};
+    std::mutex m_mutex;
+    std::vector<sf::Vector2f> m_positions;
+    uint64_t m_version = 0;
+    uint64_t m_taken = 0;
+
+    void refine(const CsrGraph& graph, const PivotDistances& distances, std::vector<sf::Vector2f> current,
+                float edgeLength, int maxIterations) {
+        const size_t n = current.size();
+        std::vector<sf::Vector2f> next(n);
+        std::vector<double> partialStress(workerCount());
+        double previousStress = std::numeric_limits<double>::max();
+
+        for (int iteration = 0; iteration < maxIterations && m_running; ++iteration) {
+            std::fill(partialStress.begin(), partialStress.end(), 0.0);
+            parallelFor(n, [&](size_t begin, size_t end, unsigned worker) {
+                double stress = 0.0;
+                for (size_t i = begin; i < end; ++i) {
+                    sf::Vector2f sum;
+                    double weightSum = 0.0;
+                    auto term = [&](size_t j, float hops) {
+                        if (j == i || hops <= 0.f) return;
+                        float target = hops * edgeLength;
+                        sf::Vector2f delta = current[i] - current[j];
+                        float length = std::sqrt(delta.x * delta.x + delta.y * delta.y);
+                        float weight = 1.f / (target * target);
+                        // Coincident nodes are pushed apart in opposite directions.
+                        sf::Vector2f pull = length > 1e-4f ? delta * (target / length)
+                                                           : sf::Vector2f(i < j ? target : -target, 0.f);
+                        sum += (current[j] + pull) * weight;
+                        weightSum += weight;
+                        stress += weight * (length - target) * (length - target);
+                    };
+                    for (const uint32_t* j = graph.begin(static_cast<uint32_t>(i)); j != graph.end(static_cast<uint32_t>(i)); ++j) {
+                        term(*j, 1.f);
+                    }
+                    for (size_t p = 0; p < distances.pivots.size(); ++p) {
+                        term(distances.pivots[p], distances.rows[p][i]);
+                    }
+                    next[i] = weightSum > 0.0 ? sum / static_cast<float>(weightSum) : current[i];
+                }
+                partialStress[worker] = stress;
+            });
+            current.swap(next);
+
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_positions = current;
+                ++m_version;
+            }
+
+            double stress = std::accumulate(partialStress.begin(), partialStress.end(), 0.0);
+            if (previousStress - stress < 1e-4 * previousStress) break;
+            previousStress = stress;
+        }
+        m_running = false;
+    }
+};
@@ -0,0 +1,418 @@
+#pragma once
+#include "Graph.hpp"
+#include "MultilevelLayout.hpp"
+#include "Trace.hpp"
+#include <SFML/Graphics.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+struct TimedEdgeEvent {
+    double time = 0.0;
+    EdgeEvent event;
+};
+
+// Reads one event per line, "<time> [+|-] <source> <target>" with node ids
+// as in edge streams ('+' may be left out). '#' starts a comment line.
+// Events are returned in time order; ties keep their file order.
+inline bool loadTimedEdgeEvents(const std::string& path, std::vector<TimedEdgeEvent>& events) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        std::cerr << "Failed to read timeline: " << path << std::endl;
+        return false;
+    }
+
+    std::string line;
+    size_t lineNumber = 0;
+    while (std::getline(file, line)) {
+        ++lineNumber;
+        const char* c = line.c_str();
+        while (*c == ' ' || *c == '\t') ++c;
+        if (*c == '\0' || *c == '\r' || *c == '#') continue;
+
+        TimedEdgeEvent timed;
+        char* end = nullptr;
+        timed.time = std::strtod(c, &end);
+        bool ok = end != c;
+        c = end;
+        while (*c == ' ' || *c == '\t') ++c;
+        if (*c == '+' || *c == '-') timed.event.remove = *c++ == '-';
+        unsigned long source = std::strtoul(c, &end, 10);
+        ok &= end != c;
+        c = end;
+        unsigned long target = std::strtoul(c, &end, 10);
+        ok &= end != c;
+        if (!ok) {
+            std::cerr << "Malformed timeline line " << lineNumber << " in " << path << std::endl;
+            return false;
+        }
+        timed.event.source = static_cast<uint32_t>(source);
+        timed.event.target = static_cast<uint32_t>(target);
+        events.push_back(timed);
+    }
+    std::stable_sort(events.begin(), events.end(),
+                     [](const TimedEdgeEvent& a, const TimedEdgeEvent& b) { return a.time < b.time; });
+    return true;
+}
+
+// A timestamped edge history with checkpoints. Edge checkpoints store the
+// sorted edge set; a new one is taken once the events since the last reach
+// that checkpoint's edge count, or the minimum interval if larger. Seeking
+// is then one checkpoint plus fewer events than it holds, O(snapshot +
+// delta) whatever the history's length, and since each checkpoint is paid
+// for by the events before it, all of them together take O(events) memory.
+// A smaller interval trades memory for shorter seeks on sparse stretches.
+//
+// Layouts are costlier, so they are kept apart: at most kMaxLayouts,
+// evenly spaced by event, with positions in between blended. Each layout
+// refines the previous one, so the picture drifts instead of jumping. Node
+// i is the i-th smallest id in the history; edges are undirected and
+// stored as (smaller, larger) indices.
+class Timeline {
+public:
+    using Key = std::pair<uint32_t, uint32_t>;
+
+    // Fewest events between edge checkpoints, unless build is given another.
+    static constexpr size_t kMinInterval = 4096;
+    // At most about this many layouts, whatever the history's length.
+    static constexpr size_t kMaxLayouts = 32;
+
+    void build(std::vector<TimedEdgeEvent> events, size_t interval = 0) {
+        TRACE_ZONE("Timeline::build");
+        m_times.clear();
+        m_events.clear();
+        m_checkpoints.clear();
+        m_layouts.clear();
+        m_ids.clear();
+
+        for (const auto& timed : events) {
+            m_ids.push_back(timed.event.source);
+            m_ids.push_back(timed.event.target);
+        }
+        std::sort(m_ids.begin(), m_ids.end());
+        m_ids.erase(std::unique(m_ids.begin(), m_ids.end()), m_ids.end());
+
+        m_times.reserve(events.size());
+        m_events.reserve(events.size());
+        for (const auto& timed : events) {
+            m_times.push_back(timed.time);
+            m_events.push_back({indexOf(timed.event.source), indexOf(timed.event.target), timed.event.remove});
+        }
+        m_interval = interval ? interval : kMinInterval;
+        const size_t total = m_events.size();
+        const size_t layoutInterval = std::max(m_interval, (total + kMaxLayouts - 1) / kMaxLayouts);
+
+        // The first layout is of every edge the history ever has, which
+        // keeps the whole playback on one map.
+        std::vector<Key> everything;
+        applyDelta({}, 0, total, everything, true);
+        m_checkpoints.push_back({});
+        m_layouts.push_back({0, MultilevelLayout().run(toCsr(everything))});
+
+        std::vector<Key> current;
+        std::vector<Key> next;
+        size_t done = 0;
+        size_t nextLayout = layoutInterval;
+        while (done < total) {
+            const Checkpoint& last = m_checkpoints.back();
+            size_t nextCheckpoint = last.event + std::max(m_interval, last.edges.size());
+            size_t end = std::min({total, nextCheckpoint, nextLayout});
+            applyDelta(current, done, end, next);
+            current.swap(next);
+            done = end;
+            if (done == nextCheckpoint || done == total) m_checkpoints.push_back({done, current});
+            if (done == nextLayout || done == total) {
+                // Only nodes with edges take part; the rest hold still
+                // rather than drift away on repulsion alone.
+                const std::vector<sf::Vector2f>& previous = m_layouts.back().positions;
+                CsrGraph csr = toCsr(current);
+                Layout layout{done, MultilevelLayout().refineFrom(csr, previous, 10)};
+                for (uint32_t u = 0; u < csr.nodeCount(); ++u) {
+                    if (csr.begin(u) == csr.end(u)) layout.positions[u] = previous[u];
+                }
+                m_layouts.push_back(std::move(layout));
+                nextLayout += layoutInterval;
+            }
+        }
+    }
+
+    size_t eventCount() const { return m_events.size(); }
+    size_t nodeCount() const { return m_ids.size(); }
+    size_t checkpointCount() const { return m_checkpoints.size(); }
+    size_t layoutCount() const { return m_layouts.size(); }
+    const std::vector<uint32_t>& getNodeIds() const { return m_ids; }
+
+    double getStartTime() const { return m_times.empty() ? 0.0 : m_times.front(); }
+    double getEndTime() const { return m_times.empty() ? 0.0 : m_times.back(); }
+
+    // Number of events at or before time.
+    size_t eventsUntil(double time) const {
+        return static_cast<size_t>(std::upper_bound(m_times.begin(), m_times.end(), time) - m_times.begin());
+    }
+
+    // The i-th event, with node ids.
+    EdgeEvent eventAt(size_t i) const {
+        const IndexEvent& event = m_events[i];
+        return {m_ids[event.source], m_ids[event.target], event.remove};
+    }
+
+    // Edges after the first count events: the checkpoint at or before
+    // count plus the events since, O(checkpoint + delta).
+    void edgesAfter(size_t count, std::vector<Key>& edges) const {
+        const Checkpoint& checkpoint = m_checkpoints[checkpointBefore(count)];
+        applyDelta(checkpoint.edges, checkpoint.event, count, edges);
+    }
+
+    // Edges and events edgesAfter(count) goes through.
+    size_t seekCost(size_t count) const {
+        const Checkpoint& checkpoint = m_checkpoints[checkpointBefore(count)];
+        return checkpoint.edges.size() + count - checkpoint.event;
+    }
+
+    // Positions after the first count events, blended between the
+    // surrounding layouts by how many events lie between.
+    void positionsAfter(size_t count, std::vector<sf::Vector2f>& positions) const {
+        auto after = std::upper_bound(m_layouts.begin(), m_layouts.end(), count,
+                                      [](size_t c, const Layout& layout) { return c < layout.event; });
+        const Layout& before = *(after - 1);
+        positions = before.positions;
+        if (after == m_layouts.end()) return;
+        float t = static_cast<float>(count - before.event) / static_cast<float>(after->event - before.event);
+        for (size_t i = 0; i < positions.size(); ++i) positions[i] += (after->positions[i] - positions[i]) * t;
+    }
+
+    size_t memoryBytes() const {
+        size_t bytes = heapBytes(m_times) + heapBytes(m_events) + heapBytes(m_ids) + heapBytes(m_checkpoints) +
+                       heapBytes(m_layouts);
+        for (const auto& checkpoint : m_checkpoints) bytes += heapBytes(checkpoint.edges);
+        for (const auto& layout : m_layouts) bytes += heapBytes(layout.positions);
+        return bytes;
+    }
+
+private:
+    struct IndexEvent {
+        uint32_t source;
+        uint32_t target;
+        bool remove;
+    };
+
+    struct Checkpoint {
+        // Events applied before this checkpoint.
+        size_t event = 0;
+        std::vector<Key> edges;
+    };
+
+    struct Layout {
+        size_t event = 0;
+        std::vector<sf::Vector2f> positions;
+    };
+
+    std::vector<double> m_times;
+    std::vector<IndexEvent> m_events;
+    std::vector<uint32_t> m_ids;
+    std::vector<Checkpoint> m_checkpoints;
+    std::vector<Layout> m_layouts;
+    size_t m_interval = kMinInterval;
+
+    uint32_t indexOf(uint32_t id) const {
+        return static_cast<uint32_t>(std::lower_bound(m_ids.begin(), m_ids.end(), id) - m_ids.begin());
+    }
+
+    size_t checkpointBefore(size_t count) const {
+        auto after = std::upper_bound(m_checkpoints.begin(), m_checkpoints.end(), count,
+                                      [](size_t c, const Checkpoint& checkpoint) { return c < checkpoint.event; });
+        return static_cast<size_t>(after - m_checkpoints.begin()) - 1;
+    }
+
+    CsrGraph toCsr(const std::vector<Key>& edges) const {
+        std::vector<Key> pairs(edges);
+        pairs.reserve(edges.size() * 2);
+        for (const Key& key : edges) pairs.emplace_back(key.second, key.first);
+        return CsrGraph::fromEdges(m_ids.size(), pairs);
+    }
+
+    // out = base with events [begin, end) applied; the last event on an
+    // edge decides whether it is present. Self loops are ignored, as the
+    // graph ignores them. With insertOnly, removals are skipped too.
+    void applyDelta(const std::vector<Key>& base, size_t begin, size_t end, std::vector<Key>& out,
+                    bool insertOnly = false) const {
+        struct Change {
+            Key key;
+            size_t order;
+            bool present;
+        };
+        std::vector<Change> changes;
+        changes.reserve(end - begin);
+        for (size_t i = begin; i < end; ++i) {
+            const IndexEvent& event = m_events[i];
+            if (event.source == event.target || (insertOnly && event.remove)) continue;
+            changes.push_back({Key(std::min(event.source, event.target), std::max(event.source, event.target)), i,
+                               !event.remove});
+        }
+        std::sort(changes.begin(), changes.end(), [](const Change& a, const Change& b) {
+            return a.key != b.key ? a.key < b.key : a.order < b.order;
+        });
+
+        out.clear();
+        out.reserve(base.size() + changes.size());
+        auto next = base.begin();
+        for (size_t i = 0; i < changes.size(); ++i) {
+            if (i + 1 < changes.size() && changes[i + 1].key == changes[i].key) continue;
+            while (next != base.end() && *next < changes[i].key) out.push_back(*next++);
+            if (next != base.end() && *next == changes[i].key) ++next;
+            if (changes[i].present) out.push_back(changes[i].key);
+        }
+        out.insert(out.end(), next, base.end());
+    }
+};
+
+// Plays a Timeline into a Graph. The clock moves in timeline units;
+// stepping forward applies the events in between as an edge stream batch
+// when there are fewer of them than a rebuild would go through, and
+// anything else rebuilds the edge set from a checkpoint. Shown positions
+// ease towards the blended layouts, so neither playback nor seeking makes
+// nodes jump.
+class TemporalPlayback {
+public:
+    // Seconds for the shown positions to close most of the gap to their
+    // targets (the time constant of the exponential easing).
+    static constexpr double kEaseSeconds = 0.15;
+
+    TemporalPlayback(Graph& graph, Timeline timeline) : m_graph(graph), m_timeline(std::move(timeline)) {
+        double span = m_timeline.getEndTime() - m_timeline.getStartTime();
+        m_speed = span > 0.0 ? span / 20.0 : 1.0;
+    }
+
+    const Timeline& getTimeline() const { return m_timeline; }
+
+    double getTime() const { return m_time; }
+    double getStartTime() const { return m_timeline.getStartTime(); }
+    double getEndTime() const { return m_timeline.getEndTime(); }
+
+    // Position of the clock between the first and last event, in [0, 1].
+    double getProgress() const {
+        double span = getEndTime() - getStartTime();
+        return span > 0.0 ? (m_time - getStartTime()) / span : 1.0;
+    }
+
+    bool isPlaying() const { return m_playing; }
+    void setPlaying(bool playing) {
+        if (playing && m_time >= getEndTime()) seek(getStartTime());
+        m_playing = playing;
+        ++m_version;
+    }
+
+    // Timeline units per second of playback; by default the whole history
+    // plays in 20 seconds.
+    void setSpeed(double speed) { m_speed = speed; }
+
+    // Changes whenever the clock or play state does.
+    uint64_t getVersion() const { return m_version; }
+
+    bool isAnimating() const { return m_playing || m_easing; }
+
+    // Moves the clock to time and shows the state there. With animate off
+    // the positions are set outright (batch jobs, the first frame).
+    void seek(double time, bool animate = true) {
+        m_time = std::min(std::max(time, getStartTime()), getEndTime());
+        moveTo(m_timeline.eventsUntil(m_time));
+        m_timeline.positionsAfter(m_applied, m_target);
+        if (!animate || m_shown.size() != m_target.size()) {
+            m_shown = m_target;
+            m_graph.applyLayout(m_shown);
+        } else {
+            m_easing = true;
+        }
+        ++m_version;
+    }
+
+    // Advances the clock by seconds of wall time while playing and eases
+    // the positions; returns true when anything changed.
+    bool update(double seconds) {
+        // Edits made while playing (deleting nodes, say) break the link
+        // between graph and timeline indices; restore the timeline's state.
+        if (m_graph.getNodes().size() != m_timeline.nodeCount()) {
+            m_applied = SIZE_MAX;
+            seek(m_time, false);
+            return true;
+        }
+        if (!m_playing && !m_easing) return false;
+
+        if (m_playing) {
+            m_time = std::min(m_time + seconds * m_speed, getEndTime());
+            moveTo(m_timeline.eventsUntil(m_time));
+            m_timeline.positionsAfter(m_applied, m_target);
+            m_easing = true;
+            if (m_time >= getEndTime()) m_playing = false;
+            ++m_version;
+        }
+
+        float blend = static_cast<float>(1.0 - std::exp(-seconds / kEaseSeconds));
+        float largest = 0.f;
+        for (size_t i = 0; i < m_shown.size(); ++i) {
+            sf::Vector2f gap = m_target[i] - m_shown[i];
+            largest = std::max(largest, std::abs(gap.x) + std::abs(gap.y));
+            m_shown[i] += gap * blend;
+        }
+        if (largest < 0.5f) {
+            m_shown = m_target;
+            m_easing = false;
+        }
+        m_graph.applyLayout(m_shown);
+        return true;
+    }
+
+private:
+    Graph& m_graph;
+    Timeline m_timeline;
+    double m_time = 0.0;
+    double m_speed = 1.0;
+    bool m_playing = false;
+    bool m_easing = false;
+    uint64_t m_version = 0;
+    // Events currently applied to the graph; SIZE_MAX before the first seek.
+    size_t m_applied = SIZE_MAX;
+    std::vector<sf::Vector2f> m_shown;
+    std::vector<sf::Vector2f> m_target;
+    std::vector<EdgeEvent> m_delta;
+    std::vector<Timeline::Key> m_edges;
+
+    void moveTo(size_t count) {
+        if (count == m_applied) return;
+        TRACE_ZONE("TemporalPlayback::moveTo");
+        if (m_applied != SIZE_MAX && count > m_applied && count - m_applied <= m_timeline.seekCost(count)) {
+            m_delta.clear();
+            for (size_t i = m_applied; i < count; ++i) m_delta.push_back(m_timeline.eventAt(i));
+            m_graph.applyEdgeEvents(m_delta);
+        } else {
+            m_timeline.edgesAfter(count, m_edges);
+            if (m_applied != SIZE_MAX && hasTimelineNodes()) {
+                // The node set never changes along a timeline; only the
+                // edges are swapped and the positions stay to ease from.
+                m_graph.replaceEdges(m_edges);
+            } else {
+                // assignEdges lays nodes out unless given positions; the
+                // current ones are kept and eased from.
+                std::vector<sf::Vector2f> positions = m_shown;
+                if (positions.size() != m_timeline.nodeCount()) m_timeline.positionsAfter(count, positions);
+                m_graph.assignEdges(m_timeline.getNodeIds(), m_edges, false, positions);
+            }
+        }
+        m_applied = count;
+    }
+
+    bool hasTimelineNodes() const {
+        const NodeStore& nodes = m_graph.getNodes();
+        const std::vector<uint32_t>& ids = m_timeline.getNodeIds();
+        if (nodes.size() != ids.size()) return false;
+        for (size_t i = 0; i < ids.size(); ++i) {
+            if (nodes.getId(i) != ids[i]) return false;
+        }
+        return true;
+    }
+};
@@ -0,0 +1,166 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Scoped timeline zones, written out in the Chrome trace-event format for
+// Perfetto or chrome://tracing. Built with GRAPH_TRACING (the CMake option
+// of the same name) TRACE_ZONE("name") records the enclosing scope; without
+// it the macro expands to nothing and costs nothing.
+//
+// Each thread writes into its own fixed-size ring, so recording takes no
+// lock: the owner is the only writer, and a flush only reads what the write
+// index has published. When a ring wraps, the oldest zones are lost. Rings
+// of exited threads go back to a pool for the next new thread (parallelFor
+// starts fresh threads for every call), so zones carry their own thread id.
+class Tracer {
+public:
+    static constexpr size_t kRingSize = 1 << 14;
+
+    static Tracer& instance() {
+        static Tracer tracer;
+        return tracer;
+    }
+
+    uint64_t now() const {
+        return static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_epoch).count());
+    }
+
+    // name must outlive the tracer (a string literal).
+    void record(const char* name, uint64_t begin, uint64_t end) {
+        ThreadSlot& slot = threadSlot();
+        Ring& ring = *slot.ring;
+        uint64_t head = ring.head.load(std::memory_order_relaxed);
+        Zone& zone = ring.zones[head % kRingSize];
+        zone.name.store(name, std::memory_order_relaxed);
+        zone.begin.store(begin, std::memory_order_relaxed);
+        zone.end.store(end, std::memory_order_relaxed);
+        zone.thread.store(slot.thread, std::memory_order_relaxed);
+        ring.head.store(head + 1, std::memory_order_release);
+    }
+
+    // Writes every zone recorded since the last flush and forgets them.
+    bool writeChromeTrace(const std::string& path) {
+        std::ofstream file(path);
+        if (!file.is_open()) {
+            std::cerr << "Failed to write trace: " << path << std::endl;
+            return false;
+        }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        file << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+        bool first = true;
+        for (const auto& ring : m_rings) {
+            uint64_t head = ring->head.load(std::memory_order_acquire);
+            uint64_t tail = std::max(ring->flushed, head > kRingSize ? head - kRingSize : 0);
+            for (uint64_t i = tail; i < head; ++i) {
+                const Zone& zone = ring->zones[i % kRingSize];
+                const char* name = zone.name.load(std::memory_order_relaxed);
+                uint64_t begin = zone.begin.load(std::memory_order_relaxed);
+                uint64_t end = zone.end.load(std::memory_order_relaxed);
+                uint32_t thread = zone.thread.load(std::memory_order_relaxed);
+                // The owner may have been rewriting this slot while it was read.
+                if (ring->head.load(std::memory_order_acquire) - i >= kRingSize) continue;
+
+                file << (first ? "" : ",\n") << "{\"name\": \"" << name << "\", \"ph\": \"X\", \"pid\": 1, \"tid\": "
+                     << thread << ", \"ts\": " << begin / 1000.0 << ", \"dur\": " << (end - begin) / 1000.0 << '}';
+                first = false;
+            }
+            ring->flushed = head;
+        }
+        file << "\n]}\n";
+        return static_cast<bool>(file);
+    }
+
+private:
+    struct Zone {
+        std::atomic<const char*> name{nullptr};
+        std::atomic<uint64_t> begin{0};
+        std::atomic<uint64_t> end{0};
+        std::atomic<uint32_t> thread{0};
+    };
+
+    struct Ring {
+        std::unique_ptr<Zone[]> zones{new Zone[kRingSize]};
+        std::atomic<uint64_t> head{0};
+        // Only touched by flushes, under m_mutex.
+        uint64_t flushed = 0;
+    };
+
+    struct ThreadSlot {
+        Ring* ring = nullptr;
+        uint32_t thread = 0;
+
+        ~ThreadSlot() {
+            if (ring) Tracer::instance().releaseRing(ring);
+        }
+    };
+
+    std::chrono::steady_clock::time_point m_epoch = std::chrono::steady_clock::now();
+    std::mutex m_mutex;
+    std::vector<std::unique_ptr<Ring>> m_rings;
+    std::vector<Ring*> m_freeRings;
+    uint32_t m_nextThread = 0;
+
+    // Registration is the only locked step, once per thread.
+    ThreadSlot& threadSlot() {
+        thread_local ThreadSlot slot;
+        if (!slot.ring) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            slot.thread = ++m_nextThread;
+            if (m_freeRings.empty()) {
+                m_rings.push_back(std::make_unique<Ring>());
+                slot.ring = m_rings.back().get();
+            } else {
+                slot.ring = m_freeRings.back();
+                m_freeRings.pop_back();
+            }
+        }
+        return slot;
+    }
+
+    void releaseRing(Ring* ring) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_freeRings.push_back(ring);
+    }
+};
+
+class TraceZone {
+public:
+    explicit TraceZone(const char* name) : m_name(name), m_begin(Tracer::instance().now()) {}
+    ~TraceZone() { Tracer::instance().record(m_name, m_begin, Tracer::instance().now()); }
+
+    TraceZone(const TraceZone&) = delete;
+    TraceZone& operator=(const TraceZone&) = delete;
+
+private:
+    const char* m_name;
+    uint64_t m_begin;
+};
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+
+#ifdef GRAPH_TRACING
+#define TRACE_ZONE(name) TraceZone TRACE_CONCAT(traceZone, __LINE__)(name)
+#else
+#define TRACE_ZONE(name) ((void)0)
+#endif
+
+// Flushes the recorded zones to path, or explains why there are none.
+inline bool writeTraceFile(const std::string& path) {
+#ifdef GRAPH_TRACING
+    return Tracer::instance().writeChromeTrace(path);
+#else
+    std::cerr << "Tracing is compiled out; configure with -DGRAPH_TRACING=ON to record " << path << std::endl;
+    return false;
+#endif
+}
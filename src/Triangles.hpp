@@ -0,0 +1,170 @@
+#pragma once
+#include "Csr.hpp"
+#include "Parallel.hpp"
+#include <cstdint>
+#include <vector>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+inline unsigned popcount64(uint64_t x) {
+#if defined(_MSC_VER)
+    return static_cast<unsigned>(__popcnt64(x));
+#else
+    return static_cast<unsigned>(__builtin_popcountll(x));
+#endif
+}
+
+// |a & b| over two bit rows. With AVX2 (the GRAPH_AVX2 CMake option) four
+// words go per step through the nibble-lookup popcount, summed per lane
+// with SAD; otherwise one POPCNT per word.
+inline uint64_t andPopcount(const uint64_t* a, const uint64_t* b, size_t words) {
+    uint64_t count = 0;
+    size_t i = 0;
+#if defined(__AVX2__)
+    const __m256i lookup = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                            0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    const __m256i lowNibble = _mm256_set1_epi8(0x0f);
+    __m256i total = _mm256_setzero_si256();
+    for (; i + 4 <= words; i += 4) {
+        __m256i both = _mm256_and_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i)),
+                                        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i)));
+        __m256i low = _mm256_shuffle_epi8(lookup, _mm256_and_si256(both, lowNibble));
+        __m256i high = _mm256_shuffle_epi8(lookup, _mm256_and_si256(_mm256_srli_epi16(both, 4), lowNibble));
+        total = _mm256_add_epi64(total, _mm256_sad_epu8(_mm256_add_epi8(low, high), _mm256_setzero_si256()));
+    }
+    count = static_cast<uint64_t>(_mm256_extract_epi64(total, 0)) + static_cast<uint64_t>(_mm256_extract_epi64(total, 1)) +
+            static_cast<uint64_t>(_mm256_extract_epi64(total, 2)) + static_cast<uint64_t>(_mm256_extract_epi64(total, 3));
+#endif
+    for (; i < words; ++i) count += popcount64(a[i] & b[i]);
+    return count;
+}
+
+// One bit per (u, v) pair, rows padded to whole 256-bit blocks. n^2 / 8
+// bytes, so only worth it when rows are dense.
+class BitsetAdjacency {
+public:
+    explicit BitsetAdjacency(const CsrGraph& graph)
+        : m_words(((graph.nodeCount() + 255) / 256) * 4), m_bits(graph.nodeCount() * m_words, 0) {
+        parallelFor(graph.nodeCount(), [&](size_t first, size_t last, unsigned) {
+            for (size_t u = first; u < last; ++u) {
+                uint64_t* bits = m_bits.data() + u * m_words;
+                for (const uint32_t* v = graph.begin(static_cast<uint32_t>(u)); v != graph.end(static_cast<uint32_t>(u)); ++v) {
+                    if (*v != u) bits[*v / 64] |= uint64_t(1) << (*v % 64);
+                }
+            }
+        }, 256);
+    }
+
+    size_t words() const { return m_words; }
+    const uint64_t* row(size_t u) const { return m_bits.data() + u * m_words; }
+
+private:
+    size_t m_words;
+    std::vector<uint64_t> m_bits;
+};
+
+struct TriangleOptions {
+    enum class Method { Auto, Bitset, Merge };
+    Method method = Method::Auto;
+    // Auto never builds a bitset beyond this many nodes (128 MiB at 2^15).
+    size_t maxBitsetNodes = size_t(1) << 15;
+};
+
+struct TriangleResult {
+    std::vector<uint64_t> triangles;
+    // Local clustering coefficient: closed over possible neighbour pairs.
+    std::vector<double> clustering;
+    uint64_t total = 0;
+    // Transitivity: 3 * triangles / connected triples.
+    double globalClustering = 0.0;
+    double averageClustering = 0.0;
+    bool usedBitset = false;
+};
+
+// Sorted-list intersection size, ignoring u and v themselves (self loops).
+inline uint64_t mergeIntersect(const uint32_t* a, const uint32_t* aEnd, const uint32_t* b, const uint32_t* bEnd,
+                               uint32_t u, uint32_t v) {
+    uint64_t count = 0;
+    while (a != aEnd && b != bEnd) {
+        if (*a < *b) {
+            ++a;
+        } else if (*b < *a) {
+            ++b;
+        } else {
+            count += *a != u && *a != v;
+            ++a;
+            ++b;
+        }
+    }
+    return count;
+}
+
+// Triangles through each node of an undirected graph whose CSR rows are
+// sorted and duplicate-free (CsrGraph::sortRows). Every row is independent:
+// node u closes |N(u) & N(v)| triangles with each neighbour v, each counted
+// from both sides, so rows split across threads with no shared writes.
+// Dense graphs intersect bitset rows; sparse ones merge the sorted lists,
+// which costs deg(u) + deg(v) instead of n / 64 words.
+inline TriangleResult computeTriangles(const CsrGraph& graph, const TriangleOptions& options = {}) {
+    TriangleResult result;
+    const size_t n = graph.nodeCount();
+    result.triangles.assign(n, 0);
+    result.clustering.assign(n, 0.0);
+    if (n == 0) return result;
+
+    const size_t words = ((n + 255) / 256) * 4;
+    double averageDegree = static_cast<double>(graph.edgeCount()) / n;
+    switch (options.method) {
+        case TriangleOptions::Method::Bitset: result.usedBitset = true; break;
+        case TriangleOptions::Method::Merge: result.usedBitset = false; break;
+        case TriangleOptions::Method::Auto:
+            result.usedBitset = n <= options.maxBitsetNodes && 2.0 * averageDegree >= static_cast<double>(words);
+            break;
+    }
+
+    std::vector<uint64_t> degrees(n, 0);
+    auto countRows = [&](auto&& intersect) {
+        parallelFor(n, [&](size_t first, size_t last, unsigned) {
+            for (size_t i = first; i < last; ++i) {
+                uint32_t u = static_cast<uint32_t>(i);
+                uint64_t closed = 0;
+                uint64_t degree = 0;
+                for (const uint32_t* v = graph.begin(u); v != graph.end(u); ++v) {
+                    if (*v == u) continue;
+                    ++degree;
+                    closed += intersect(u, *v);
+                }
+                result.triangles[u] = closed / 2;
+                degrees[u] = degree;
+            }
+        }, 64);
+    };
+
+    if (result.usedBitset) {
+        BitsetAdjacency bits(graph);
+        countRows([&](uint32_t u, uint32_t v) { return andPopcount(bits.row(u), bits.row(v), bits.words()); });
+    } else {
+        countRows([&](uint32_t u, uint32_t v) {
+            return mergeIntersect(graph.begin(u), graph.end(u), graph.begin(v), graph.end(v), u, v);
+        });
+    }
+
+    uint64_t closedSum = 0;
+    double triples = 0.0;
+    double localSum = 0.0;
+    for (size_t u = 0; u < n; ++u) {
+        double pairs = degrees[u] < 2 ? 0.0 : degrees[u] * (degrees[u] - 1) / 2.0;
+        if (pairs > 0.0) result.clustering[u] = result.triangles[u] / pairs;
+        closedSum += result.triangles[u];
+        triples += pairs;
+        localSum += result.clustering[u];
+    }
+    result.total = closedSum / 3;
+    result.globalClustering = triples > 0.0 ? closedSum / triples : 0.0;
+    result.averageClustering = localSum / n;
+    return result;
+}
@@ -1,178 +1,173 @@
 #include <SFML/Graphics.hpp>
+#include <chrono>
+#include <thread>
 #include <iostream>
+#include <memory>
+#include <string>
+#include "Cli.hpp"
+#include "EventLog.hpp"
 #include "Graph.hpp"
+#include "GraphView.hpp"
+#include "Interaction.hpp"
+#include "RenderScheduler.hpp"
+#include "Timeline.hpp"
+
+int main(int argc, char** argv) {
+    CliOptions options;
+    if (argc > 1) {
+        if (!parseCliArguments(argc, argv, options)) {
+            printCliUsage();
+            return -1;
+        }
+        if (!options.isInteractive()) return runCli(options);
+    }
 
-const float MIN_DISTANCE = 50.f;
-const float MOVE_SPEED = 0.3f;
-
-int main() {
-    sf::RenderWindow window(sf::VideoMode(800, 600), "Graph Visualization");
-    window.setFramerateLimit(60);
-
+    EventReplayer replayer;
+    EventLogHeader header;
+    if (!options.replayPath.empty()) {
+        if (!replayer.open(options.replayPath)) return -1;
+        header = replayer.getHeader();
+        if (!options.input.empty()) header.input = options.input;
+    } else {
+        header.input = options.input;
+    }
 
     sf::Font font;
-    if (!font.loadFromFile("../Fonts/Arial.ttf")) {
+    if (!font.loadFromFile(options.fontPath)) {
         std::cerr << "Error loading font" << std::endl;
         return -1;
     }
 
-    Graph graph(window, font, "../GraphVisualizer/adjacency_matrix.txt");
-
-    Node* draggedNode = nullptr;
-    Node* selectedNode = nullptr;
-    bool isDragging = false;
-    bool isDrawingMode = false;
+    sf::RenderWindow window(sf::VideoMode(header.window.x, header.window.y), "Graph Visualization");
+    // Replays run as fast as the events can be handled and drawn; streams
+    // cap drawing through the scheduler instead, so display() never blocks
+    // ingestion.
+    bool streaming = !options.streamPath.empty();
+    window.setFramerateLimit(options.replayPath.empty() && !streaming ? 60 : 0);
+
+    // A replay must not overwrite the matrix file of an earlier session, and
+    // streams and timelines would rewrite it every frame.
+    bool persist = options.replayPath.empty() && !streaming && options.timelinePath.empty();
+    Graph graph(persist ? "../GraphVisualizer/adjacency_matrix.txt" : "");
+    GraphView view(graph, window, font);
+    if (!header.input.empty() && !graph.loadFile(header.input)) return -1;
+    if (options.removeOverlaps) graph.removeOverlaps();
+
+    // Recorded and replayed sessions both finish layouts synchronously, so
+    // the replay sees the positions the recorded events were aimed at.
+    Interaction interaction(graph, &view, &window, window.getSize());
+    interaction.setDeterministic(!options.recordPath.empty() || !options.replayPath.empty());
+
+    std::unique_ptr<TemporalPlayback> playback;
+    if (!options.timelinePath.empty()) {
+        std::vector<TimedEdgeEvent> events;
+        if (!loadTimedEdgeEvents(options.timelinePath, events)) return -1;
+        Timeline timeline;
+        timeline.build(std::move(events));
+        playback = std::make_unique<TemporalPlayback>(graph, std::move(timeline));
+        playback->seek(playback->getStartTime(), false);
+        playback->setPlaying(true);
+        view.setPlayback(playback.get());
+        interaction.setPlayback(playback.get());
+    }
 
+    if (!options.replayPath.empty()) {
+        LatencyReport report;
+        replayEvents(replayer, options.realtime, report, [&](const sf::Event& event) {
+            // Only closing the window interrupts a replay.
+            sf::Event live;
+            while (window.pollEvent(live)) {
+                if (live.type == sf::Event::Closed) return false;
+            }
 
-    sf::Text statusText;
-    statusText.setFont(font);
-    statusText.setCharacterSize(14);
-    statusText.setFillColor(sf::Color::Black);
-    statusText.setPosition(10.f, window.getSize().y - 30.f);
+            bool keepGoing = interaction.handleEvent(event);
+            graph.pollLayout();
+            window.clear(sf::Color::White);
+            view.draw(true);
+            window.display();
+            return keepGoing;
+        });
+        report.printSummary(std::cout);
+        if (!options.latencyPath.empty() && !report.writeCsv(options.latencyPath)) return -1;
+        if (!options.tracePath.empty() && !writeTraceFile(options.tracePath)) return -1;
+        return 0;
+    }
 
+    EdgeStreamReader stream;
+    if (streaming && !stream.start(options.streamPath)) return -1;
+    std::vector<EdgeEvent> streamed;
+    streamed.reserve(kStreamBatchSize);
+
+    // Applies queued stream events in batches until the queue is empty or
+    // the frame's ingest budget is spent; returns how many were taken.
+    auto ingestStream = [&]() {
+        const auto budget = std::chrono::milliseconds(12);
+        const auto start = std::chrono::steady_clock::now();
+        size_t taken = 0;
+        do {
+            streamed.clear();
+            size_t count = stream.poll(streamed, kStreamBatchSize);
+            if (count == 0) break;
+            graph.applyEdgeEvents(streamed);
+            taken += count;
+        } while (std::chrono::steady_clock::now() - start < budget);
+        return taken;
+    };
+
+    EventRecorder recorder;
+    if (!options.recordPath.empty() && !recorder.open(options.recordPath, header)) return -1;
+    const auto sessionStart = std::chrono::steady_clock::now();
+
+    auto handleEvent = [&](const sf::Event& event) {
+        if (recorder.isOpen()) {
+            auto elapsed = std::chrono::steady_clock::now() - sessionStart;
+            recorder.record(std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count(), event);
+        }
+        if (!interaction.handleEvent(event)) window.close();
+    };
+
+    // Redraw only when something visible changed; with nothing changing
+    // and nothing animating, sleep in waitEvent until the next input.
+    auto lastFrame = std::chrono::steady_clock::now();
+    RenderScheduler scheduler;
+    if (streaming) scheduler.setMinInterval(std::chrono::milliseconds(50));
     while (window.isOpen()) {
+        bool ingesting = streaming && !stream.isFinished();
         sf::Event event;
+        if (scheduler.canWait(view.getFrameVersion(), view.isAnimating() || ingesting) && window.waitEvent(event)) {
+            scheduler.observe(event);
+            handleEvent(event);
+        }
         while (window.pollEvent(event)) {
-            switch (event.type) {
-                case sf::Event::Closed:
-                    window.close();
-                    break;
-
-                case sf::Event::KeyPressed:
-                    if (event.key.code == sf::Keyboard::Escape) {
-
-                        if (selectedNode) {
-                            selectedNode->setHighlighted(false);
-                            selectedNode = nullptr;
-                        }
-                        window.close();
-                    }
-
-                    else if (event.key.code == sf::Keyboard::D) {
-                        isDrawingMode = !isDrawingMode;
-
-                        if (selectedNode) {
-                            selectedNode->setHighlighted(false);
-                            selectedNode = nullptr;
-                        }
-                        graph.updateModeText(isDrawingMode);
-                        std::cout << (isDrawingMode ? "Edge Drawing Mode" : "Node Moving Mode") << std::endl;
-                    }
-                    break;
-
-                case sf::Event::MouseButtonPressed: {
-                    if (event.mouseButton.button == sf::Mouse::Left) {
-                        sf::Vector2f mousePos = window.mapPixelToCoords(sf::Mouse::getPosition(window));
-
-
-                        if (graph.handleToggleClick(mousePos)) {
-                            break;
-                        }
-
-                        bool nodeClicked = false;
-
-                        for (const auto& node : graph.getNodes()) {
-                            if (node->containsPoint(mousePos)) {
-                                nodeClicked = true;
-
-                                if (isDrawingMode) {
-                                    if (!selectedNode) {
-
-                                        selectedNode = node.get();
-                                        selectedNode->setHighlighted(true);
-                                    } else if (node.get() != selectedNode) {
-
-                                        graph.addEdge(selectedNode, node.get());
-
-                                        selectedNode->setHighlighted(false);
-                                        selectedNode = nullptr;
-                                    }
-                                } else {
-
-                                    draggedNode = node.get();
-                                    isDragging = true;
-                                    draggedNode->setHighlighted(true);
-                                }
-                                break;
-                            }
-                        }
-
-
-                        if (!nodeClicked && !isDrawingMode) {
-                            graph.addNode(mousePos);
-                        }
-                    }
-
-                    else if (event.mouseButton.button == sf::Mouse::Right) {
-                        if (selectedNode) {
-                            selectedNode->setHighlighted(false);
-                            selectedNode = nullptr;
-                        }
-                    }
-                    break;
-                }
-
-                case sf::Event::MouseButtonReleased:
-                    if (event.mouseButton.button == sf::Mouse::Left) {
-                        if (isDragging && draggedNode) {
-                            draggedNode->setHighlighted(false);
-                            draggedNode = nullptr;
-                            isDragging = false;
-                        }
-                    }
-                    break;
-
-                case sf::Event::MouseMoved:
-                    if (isDragging && draggedNode) {
-                        sf::Vector2f mousePos = window.mapPixelToCoords(sf::Mouse::getPosition(window));
-                        bool canMove = true;
-
-
-                        for (const auto& node : graph.getNodes()) {
-                            if (node.get() != draggedNode) {
-                                sf::Vector2f nodePos = node->getPosition();
-                                float dx = mousePos.x - nodePos.x;
-                                float dy = mousePos.y - nodePos.y;
-                                float distance = std::sqrt(dx * dx + dy * dy);
-
-                                if (distance < MIN_DISTANCE) {
-                                    canMove = false;
-                                    break;
-                                }
-                            }
-                        }
-
-
-                        if (canMove) {
-                            sf::Vector2f currentPos = draggedNode->getPosition();
-                            sf::Vector2f direction = mousePos - currentPos;
-                            float length = std::sqrt(direction.x * direction.x + direction.y * direction.y);
-
-                            if (length > 0) {
-                                direction /= length;
-                                sf::Vector2f newPos = currentPos + direction * MOVE_SPEED * length;
-
-
-                                newPos.x = std::max(20.f, std::min(newPos.x, window.getSize().x - 20.f));
-                                newPos.y = std::max(20.f, std::min(newPos.y, window.getSize().y - 20.f));
-
-                                draggedNode->setPosition(newPos);
-                                graph.updateEdges();
-                            }
-                        }
-                    }
-                    break;
-            }
+            scheduler.observe(event);
+            handleEvent(event);
         }
 
+        graph.pollLayout();
+        auto now = std::chrono::steady_clock::now();
+        if (playback) playback->update(std::chrono::duration<double>(now - lastFrame).count());
+        lastFrame = now;
+        size_t ingested = ingesting ? ingestStream() : 0;
+
+        uint64_t version = view.getFrameVersion();
+        if (!scheduler.shouldDraw(version, view.hasNewFrame())) {
+            // Something is still in flight or drawing is capped; check back
+            // shortly, right away while the stream has more.
+            if (ingested == 0 && (view.isAnimating() || ingesting || scheduler.isThrottled())) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(4));
+            }
+            continue;
+        }
 
         window.clear(sf::Color::White);
 
 
-        graph.draw();
+        view.draw();
 
         window.display();
+        scheduler.markDrawn(version);
     }
 
+    if (!options.tracePath.empty() && !writeTraceFile(options.tracePath)) return -1;
     return 0;
 }